@@ -0,0 +1,248 @@
+#include "batch.h"
+#include "scheduler.h"
+#include <pthread.h>
+
+// Bounded blocking queue connecting two pipeline stages
+typedef struct {
+    t_batch_item **items;
+    int capacity;
+    int head;
+    int count;
+    int closed;
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+} t_batch_queue;
+
+typedef struct {
+    t_batch_item *items;
+    int count;
+    int saved;
+    t_batch_queue loaded;
+    t_batch_queue filtered;
+    t_batch_filter filter;
+    void *ctx;
+} t_batch;
+
+// Scheduler task for one image
+typedef struct {
+    t_batch *batch;
+    t_batch_item *item;
+} t_batch_job;
+
+static int queue_init(t_batch_queue *queue, int capacity) {
+    queue->items = (t_batch_item **)malloc(capacity * sizeof(t_batch_item *));
+    if (!queue->items) return 0;
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->count = 0;
+    queue->closed = 0;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->notEmpty, NULL);
+    pthread_cond_init(&queue->notFull, NULL);
+    return 1;
+}
+
+static void queue_destroy(t_batch_queue *queue) {
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->notEmpty);
+    pthread_cond_destroy(&queue->notFull);
+    free(queue->items);
+}
+
+static void queue_push(t_batch_queue *queue, t_batch_item *item) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->capacity) {
+        pthread_cond_wait(&queue->notFull, &queue->lock);
+    }
+    queue->items[(queue->head + queue->count) % queue->capacity] = item;
+    queue->count++;
+    pthread_cond_signal(&queue->notEmpty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+// Returns NULL once the queue is closed and drained
+static t_batch_item *queue_pop(t_batch_queue *queue) {
+    t_batch_item *item = NULL;
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && !queue->closed) {
+        pthread_cond_wait(&queue->notEmpty, &queue->lock);
+    }
+    if (queue->count > 0) {
+        item = queue->items[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        pthread_cond_signal(&queue->notFull);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return item;
+}
+
+static void queue_close(t_batch_queue *queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = 1;
+    pthread_cond_broadcast(&queue->notEmpty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+// Bits per pixel from the BMP header, or 0 if it cannot be read. Picking
+// the loader from it keeps the 8-bit loader from reporting every 24-bit
+// file as a depth mismatch.
+static int batch_colorDepth(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+
+    uint8_t header[BITMAP_DEPTH + 2];
+    int depth = 0;
+    if (fread(header, 1, sizeof(header), file) == sizeof(header) && header[0] == 'B' && header[1] == 'M') {
+        depth = header[BITMAP_DEPTH] | header[BITMAP_DEPTH + 1] << 8;
+    }
+    fclose(file);
+    return depth;
+}
+
+// Stage 1: decode files ahead of the filter stage
+static void *batch_reader(void *arg) {
+    t_batch *batch = (t_batch *)arg;
+
+    for (int i = 0; i < batch->count; i++) {
+        t_batch_item *item = &batch->items[i];
+
+        int depth = batch_colorDepth(item->input);
+        if (depth == 8) {
+            item->gray = bmp8_loadImage(item->input);
+        } else if (depth == DEFAULT_DEPTH) {
+            item->color = bmp24_loadImage(item->input);
+        }
+        if (!item->gray && !item->color) {
+            fprintf(stderr, "Error: Could not load image %s\n", item->input);
+            continue;
+        }
+        queue_push(&batch->loaded, item);
+    }
+
+    queue_close(&batch->loaded);
+    return NULL;
+}
+
+// Stage 2: each image is a scheduler task, so small and large images share
+// the workers; filters split large images further into row bands
+static void batch_filterTask(void *arg) {
+    t_batch_job *job = (t_batch_job *)arg;
+    t_batch_item *item = job->item;
+    if (job->batch->filter && !job->batch->filter(item, job->batch->ctx)) {
+        bmp8_free(item->gray);
+        bmp24_free(item->color);
+        item->gray = NULL;
+        item->color = NULL;
+    }
+    queue_push(&job->batch->filtered, item);
+}
+
+// Stage 3: encode and release images behind the filter stage
+static void *batch_writer(void *arg) {
+    t_batch *batch = (t_batch *)arg;
+    t_batch_item *item;
+
+    while ((item = queue_pop(&batch->filtered)) != NULL) {
+        int saved = 0;
+        if (item->gray) {
+            saved = bmp8_saveImage(item->output, item->gray);
+            bmp8_free(item->gray);
+            item->gray = NULL;
+        } else if (item->color) {
+            saved = bmp24_saveImage(item->color, item->output);
+            bmp24_free(item->color);
+            item->color = NULL;
+        }
+        if (saved) batch->saved++;
+    }
+    return NULL;
+}
+
+int batch_run(const char **inputs, const char **outputs, int count,
+              t_batch_filter filter, void *ctx, int queueDepth) {
+    if (!inputs || !outputs || count <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+    if (queueDepth < 1) queueDepth = 1;
+
+    t_batch batch;
+    batch.count = count;
+    batch.saved = 0;
+    batch.filter = filter;
+    batch.ctx = ctx;
+    batch.items = (t_batch_item *)calloc(count, sizeof(t_batch_item));
+    t_batch_job *jobs = (t_batch_job *)calloc(count, sizeof(t_batch_job));
+    if (!batch.items || !jobs) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(batch.items);
+        free(jobs);
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        batch.items[i].input = inputs[i];
+        batch.items[i].output = outputs[i];
+    }
+
+    if (!queue_init(&batch.loaded, queueDepth)) {
+        free(batch.items);
+        free(jobs);
+        return 0;
+    }
+    if (!queue_init(&batch.filtered, queueDepth)) {
+        queue_destroy(&batch.loaded);
+        free(batch.items);
+        free(jobs);
+        return 0;
+    }
+
+    pthread_t reader, writer;
+    if (pthread_create(&reader, NULL, batch_reader, &batch) != 0) {
+        fprintf(stderr, "Error: Could not start reader thread\n");
+        queue_destroy(&batch.loaded);
+        queue_destroy(&batch.filtered);
+        free(batch.items);
+        free(jobs);
+        return 0;
+    }
+    if (pthread_create(&writer, NULL, batch_writer, &batch) != 0) {
+        fprintf(stderr, "Error: Could not start writer thread\n");
+        // Drain the reader so it can finish, then give up
+        t_batch_item *item;
+        while ((item = queue_pop(&batch.loaded)) != NULL) {
+            bmp8_free(item->gray);
+            bmp24_free(item->color);
+        }
+        pthread_join(reader, NULL);
+        queue_destroy(&batch.loaded);
+        queue_destroy(&batch.filtered);
+        free(batch.items);
+        free(jobs);
+        return 0;
+    }
+
+    // Stage 2: hand decoded images to the scheduler, keeping at most
+    // queueDepth of them in flight
+    t_task_group group = {0};
+    t_batch_item *item;
+    while ((item = queue_pop(&batch.loaded)) != NULL) {
+        t_batch_job *job = &jobs[item - batch.items];
+        job->batch = &batch;
+        job->item = item;
+        scheduler_spawn(&group, batch_filterTask, job);
+        scheduler_waitUntil(&group, queueDepth);
+    }
+    scheduler_wait(&group);
+    queue_close(&batch.filtered);
+
+    pthread_join(reader, NULL);
+    pthread_join(writer, NULL);
+
+    queue_destroy(&batch.loaded);
+    queue_destroy(&batch.filtered);
+    free(batch.items);
+    free(jobs);
+    return batch.saved;
+}
@@ -0,0 +1,29 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "bmp8.h"
+#include "bmp24.h"
+
+// One file travelling through the batch pipeline. Exactly one of gray or
+// color is set once the file has been decoded.
+typedef struct {
+    const char *input;
+    const char *output;
+    t_bmp8 *gray;
+    t_bmp24 *color;
+} t_batch_item;
+
+// Filter stage callback, called once per successfully loaded image. Calls
+// for different images may run concurrently on the scheduler threads.
+// Returns 0 if the image could not be filtered; it is then not saved.
+typedef int (*t_batch_filter)(t_batch_item *item, void *ctx);
+
+// Runs load -> filter -> save over count files as a three-stage pipeline:
+// a reader thread decodes ahead and a writer thread encodes behind while
+// each image is filtered as its own scheduler task, with at most
+// queueDepth images waiting between two stages. Returns the number of
+// files saved.
+int batch_run(const char **inputs, const char **outputs, int count,
+              t_batch_filter filter, void *ctx, int queueDepth);
+
+#endif // BATCH_H
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bmp8.h"
+#include "bmp24.h"
+#include "fft.h"
+#include "pool.h"
+#include "scheduler.h"
+
+// Measures the filters on synthetic images and prints the settings that
+// suit the machine, to be passed to processing_image.
+
+#define BENCHMARK_RUNS 3
+#define BENCHMARK_MAX_KERNEL 31
+
+static double benchmark_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static t_bmp8 *benchmark_grayImage(int width, int height) {
+    t_bmp8 *img = bmp8_allocate(width, height);
+    if (!img) return NULL;
+
+    srand(1);
+    for (size_t i = 0; i < (size_t)img->stride * height; i++) {
+        img->data[i] = (unsigned char)(rand() & 0xFF);
+    }
+    return img;
+}
+
+static float **benchmark_boxKernel(int size) {
+    float **kernel = (float **)malloc(size * sizeof(float *));
+    if (!kernel) return NULL;
+    for (int i = 0; i < size; i++) {
+        kernel[i] = (float *)malloc(size * sizeof(float));
+        for (int j = 0; j < size; j++) kernel[i][j] = 1.0f / (size * size);
+    }
+    return kernel;
+}
+
+static void benchmark_freeKernel(float **kernel, int size) {
+    for (int i = 0; i < size; i++) free(kernel[i]);
+    free(kernel);
+}
+
+// Best of BENCHMARK_RUNS timings of bmp8_applyFilter, in milliseconds
+static double benchmark_filter(t_bmp8 *img, float **kernel, int size) {
+    double best = 0;
+    for (int run = 0; run < BENCHMARK_RUNS; run++) {
+        double start = benchmark_now();
+        bmp8_applyFilter(img, kernel, size);
+        double elapsed = (benchmark_now() - start) * 1000.0;
+        if (run == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+// Direct summation and FFT convolution for growing kernels. The crossover
+// is the smallest size from which the FFT stays faster.
+static int benchmark_fftCrossover(int width, int height) {
+    t_bmp8 *img = benchmark_grayImage(width, height);
+    if (!img) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 0;
+    }
+
+    int crossover = 0;
+    printf("Convolution on %dx%d 8-bit, %d threads\n", width, height, scheduler_threadCount());
+    printf("%8s %12s %12s\n", "kernel", "direct ms", "fft ms");
+
+    for (int size = 3; size <= BENCHMARK_MAX_KERNEL; size += 2) {
+        float **kernel = benchmark_boxKernel(size);
+        if (!kernel) break;
+
+        fft_setCrossover(size + 1);
+        double direct = benchmark_filter(img, kernel, size);
+        fft_setCrossover(size);
+        double fft = benchmark_filter(img, kernel, size);
+        benchmark_freeKernel(kernel, size);
+
+        printf("%8d %12.2f %12.2f\n", size, direct, fft);
+        if (fft < direct) {
+            if (!crossover) crossover = size;
+        } else {
+            crossover = 0;
+        }
+    }
+
+    bmp8_free(img);
+    return crossover ? crossover : BENCHMARK_MAX_KERNEL + 2;
+}
+
+// Black and white dithering throughput of both methods. Each run starts
+// from a fresh copy of the noise, as dithering works in place.
+static void benchmark_dither(int width, int height) {
+    t_bmp8 *source = benchmark_grayImage(width, height);
+    t_bmp8 *img = benchmark_grayImage(width, height);
+    if (!source || !img) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        bmp8_free(source);
+        bmp8_free(img);
+        return;
+    }
+
+    const char *names[] = {"floyd", "bayer"};
+    t_dither_method methods[] = {DITHER_FLOYD_STEINBERG, DITHER_BAYER};
+    printf("Dithering to 2 levels on %dx%d 8-bit, %d threads\n", width, height, scheduler_threadCount());
+    printf("%8s %12s %12s\n", "method", "ms", "Mpx/s");
+
+    for (int m = 0; m < 2; m++) {
+        double best = 0;
+        for (int run = 0; run < BENCHMARK_RUNS; run++) {
+            memcpy(img->data, source->data, (size_t)img->stride * height);
+            double start = benchmark_now();
+            bmp8_dither(img, 2, methods[m]);
+            double elapsed = (benchmark_now() - start) * 1000.0;
+            if (run == 0 || elapsed < best) best = elapsed;
+        }
+        printf("%8s %12.2f %12.1f\n", names[m], best, (double)width * height / (best * 1000.0));
+    }
+
+    bmp8_free(source);
+    bmp8_free(img);
+}
+
+int main(int argc, char *argv[]) {
+    int width = 1024, height = 1024;
+
+    if (argc == 3) {
+        width = atoi(argv[1]);
+        height = atoi(argv[2]);
+    }
+    if ((argc != 1 && argc != 3) || width <= 0 || height <= 0) {
+        printf("Usage: %s [<width> <height>]\n", argv[0]);
+        return 1;
+    }
+
+    int crossover = benchmark_fftCrossover(width, height);
+    printf("FFT crossover: kernel size %d (default %d)\n", crossover, FFT_DEFAULT_CROSSOVER);
+    printf("Use: processing_image --fft-crossover %d\n", crossover);
+
+    printf("\n");
+    benchmark_dither(width, height);
+
+    scheduler_shutdown();
+    pool_clear();
+    return 0;
+}
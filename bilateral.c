@@ -0,0 +1,285 @@
+#include "bilateral.h"
+#include "pool.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Largest grid buffer; two are needed
+#define BILATERAL_MAX_GRID ((size_t)256 << 20)
+
+// Position of a sample between two grid cells along one axis
+typedef struct {
+    int cell;       // Cell at or before the sample
+    float weight;   // Weight of the next cell
+} t_bilateral_span;
+
+// Grid cells hold a (sum, weight) pair; intensity varies fastest, then x,
+// then y, so that blurs along x and y run over contiguous cells
+typedef struct {
+    uint8_t **rows;
+    int width;
+    int height;
+    int gridWidth;
+    int gridHeight;
+    int gridDepth;
+    const int *splatColumns;        // Nearest cell of each image column
+    const int *splatRows;
+    const int *splatValues;
+    const t_bilateral_span *columns;
+    const t_bilateral_span *lines;
+    const t_bilateral_span *values;
+    const float *kernel;            // Blur weights, centered on radius
+    int radius;
+    const float *src;
+    float *dst;
+} t_bilateral_args;
+
+static size_t bilateral_rowSize(const t_bilateral_args *args) {
+    return (size_t)args->gridWidth * args->gridDepth * 2;
+}
+
+// One more cell than the last sample needs, for its interpolation
+static size_t bilateral_layout(t_bilateral_args *args, float cellSpatial, float cellRange) {
+    args->gridWidth = (int)((args->width - 1) / cellSpatial) + 2;
+    args->gridHeight = (int)((args->height - 1) / cellSpatial) + 2;
+    args->gridDepth = (int)(255 / cellRange) + 2;
+    return (size_t)args->gridHeight * bilateral_rowSize(args) * sizeof(float);
+}
+
+// Each task owns the grid rows [begin, end) and the image rows nearest them
+static void bilateral_splat(void *ctx, int begin, int end) {
+    t_bilateral_args *args = (t_bilateral_args *)ctx;
+    size_t rowSize = bilateral_rowSize(args);
+    memset(args->dst + (size_t)begin * rowSize, 0, (size_t)(end - begin) * rowSize * sizeof(float));
+
+    for (int y = 0; y < args->height; y++) {
+        int gy = args->splatRows[y];
+        if (gy < begin) continue;
+        if (gy >= end) break;
+
+        float *gridRow = args->dst + (size_t)gy * rowSize;
+        const uint8_t *row = args->rows[y];
+        for (int x = 0; x < args->width; x++) {
+            float *cell = gridRow + ((size_t)args->splatColumns[x] * args->gridDepth + args->splatValues[row[x]]) * 2;
+            cell[0] += row[x];
+            cell[1] += 1.0f;
+        }
+    }
+}
+
+// Blur along x within each grid row; cells outside the grid are empty
+static void bilateral_blurX(void *ctx, int begin, int end) {
+    t_bilateral_args *args = (t_bilateral_args *)ctx;
+    size_t rowSize = bilateral_rowSize(args);
+    size_t cellSize = (size_t)args->gridDepth * 2;
+
+    for (int gy = begin; gy < end; gy++) {
+        const float *src = args->src + (size_t)gy * rowSize;
+        float *dst = args->dst + (size_t)gy * rowSize;
+        for (int gx = 0; gx < args->gridWidth; gx++) {
+            float *out = dst + gx * cellSize;
+            memset(out, 0, cellSize * sizeof(float));
+            for (int k = -args->radius; k <= args->radius; k++) {
+                if (gx + k < 0 || gx + k >= args->gridWidth) continue;
+                float weight = args->kernel[k + args->radius];
+                const float *in = src + (gx + k) * cellSize;
+                for (size_t i = 0; i < cellSize; i++) out[i] += weight * in[i];
+            }
+        }
+    }
+}
+
+static void bilateral_blurY(void *ctx, int begin, int end) {
+    t_bilateral_args *args = (t_bilateral_args *)ctx;
+    size_t rowSize = bilateral_rowSize(args);
+
+    for (int gy = begin; gy < end; gy++) {
+        float *out = args->dst + (size_t)gy * rowSize;
+        memset(out, 0, rowSize * sizeof(float));
+        for (int k = -args->radius; k <= args->radius; k++) {
+            if (gy + k < 0 || gy + k >= args->gridHeight) continue;
+            float weight = args->kernel[k + args->radius];
+            const float *in = args->src + (size_t)(gy + k) * rowSize;
+            for (size_t i = 0; i < rowSize; i++) out[i] += weight * in[i];
+        }
+    }
+}
+
+static void bilateral_blurZ(void *ctx, int begin, int end) {
+    t_bilateral_args *args = (t_bilateral_args *)ctx;
+    int depth = args->gridDepth;
+    size_t rowSize = bilateral_rowSize(args);
+
+    for (int gy = begin; gy < end; gy++) {
+        for (int gx = 0; gx < args->gridWidth; gx++) {
+            size_t offset = (size_t)gy * rowSize + (size_t)gx * depth * 2;
+            const float *in = args->src + offset;
+            float *out = args->dst + offset;
+            for (int gz = 0; gz < depth; gz++) {
+                float sum = 0, weight = 0;
+                for (int k = -args->radius; k <= args->radius; k++) {
+                    if (gz + k < 0 || gz + k >= depth) continue;
+                    sum += args->kernel[k + args->radius] * in[(gz + k) * 2];
+                    weight += args->kernel[k + args->radius] * in[(gz + k) * 2 + 1];
+                }
+                out[gz * 2] = sum;
+                out[gz * 2 + 1] = weight;
+            }
+        }
+    }
+}
+
+// Trilinear interpolation of the blurred grid at every pixel
+static void bilateral_slice(void *ctx, int begin, int end) {
+    t_bilateral_args *args = (t_bilateral_args *)ctx;
+    size_t rowSize = bilateral_rowSize(args);
+    size_t cellSize = (size_t)args->gridDepth * 2;
+
+    for (int y = begin; y < end; y++) {
+        t_bilateral_span line = args->lines[y];
+        const float *top = args->src + (size_t)line.cell * rowSize;
+        const float *bottom = top + rowSize;
+        uint8_t *row = args->rows[y];
+
+        for (int x = 0; x < args->width; x++) {
+            t_bilateral_span column = args->columns[x];
+            t_bilateral_span value = args->values[row[x]];
+            size_t offset = column.cell * cellSize + value.cell * 2;
+            const float *c00 = top + offset;
+            const float *c10 = bottom + offset;
+            float sum = 0, weight = 0;
+
+            // Blend along intensity, then x, then y
+            for (int i = 0; i < 2; i++) {
+                float a = c00[i] + value.weight * (c00[i + 2] - c00[i]);
+                float b = c00[cellSize + i] + value.weight * (c00[cellSize + i + 2] - c00[cellSize + i]);
+                float c = c10[i] + value.weight * (c10[i + 2] - c10[i]);
+                float d = c10[cellSize + i] + value.weight * (c10[cellSize + i + 2] - c10[cellSize + i]);
+                float upper = a + column.weight * (b - a);
+                float lower = c + column.weight * (d - c);
+                float result = upper + line.weight * (lower - upper);
+                if (i == 0) sum = result;
+                else weight = result;
+            }
+
+            if (weight > 0) {
+                float filtered = sum / weight + 0.5f;
+                row[x] = (uint8_t)(filtered > 255 ? 255 : (filtered < 0 ? 0 : filtered));
+            }
+        }
+    }
+}
+
+static void bilateral_spans(t_bilateral_span *spans, int *nearest, int count, float cell) {
+    for (int i = 0; i < count; i++) {
+        float position = i / cell;
+        spans[i].cell = (int)position;
+        spans[i].weight = position - spans[i].cell;
+        nearest[i] = (int)(position + 0.5f);
+    }
+}
+
+int bilateral_grid(uint8_t **rows, int width, int height, float sigmaSpatial, float sigmaRange,
+                   int samplesPerSigma) {
+    if (!rows || width <= 0 || height <= 0 || sigmaSpatial <= 0 || sigmaRange <= 0 || samplesPerSigma < 1) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    // Cells finer than a pixel or a gray level would add nothing
+    float cellSpatial = sigmaSpatial / samplesPerSigma;
+    float cellRange = sigmaRange / samplesPerSigma;
+    if (cellSpatial < 1) cellSpatial = 1;
+    if (cellRange < 1) cellRange = 1;
+
+    t_bilateral_args args;
+    args.rows = rows;
+    args.width = width;
+    args.height = height;
+    // Small spatial sigmas on large images would need gigabytes: their
+    // cells are widened until the grid fits, sampling sigma more coarsely
+    size_t gridSize = bilateral_layout(&args, cellSpatial, cellRange);
+    while (gridSize > BILATERAL_MAX_GRID) {
+        cellSpatial *= 1.25f;
+        gridSize = bilateral_layout(&args, cellSpatial, cellRange);
+    }
+
+    float sigmaCells = sigmaSpatial / cellSpatial;
+    float rangeCells = sigmaRange / cellRange;
+
+    // Blurs are cut at two sigmas, like the classic grid's 1-4-6-4-1
+    int radiusSpatial = (int)ceilf(2 * sigmaCells);
+    int radiusRange = (int)ceilf(2 * rangeCells);
+    float *kernelSpatial = (float *)malloc((2 * radiusSpatial + 1) * sizeof(float));
+    float *kernelRange = (float *)malloc((2 * radiusRange + 1) * sizeof(float));
+    t_bilateral_span *columns = (t_bilateral_span *)malloc(width * sizeof(t_bilateral_span));
+    t_bilateral_span *lines = (t_bilateral_span *)malloc(height * sizeof(t_bilateral_span));
+    t_bilateral_span values[256];
+    int *splatColumns = (int *)malloc(width * sizeof(int));
+    int *splatRows = (int *)malloc(height * sizeof(int));
+    int splatValues[256];
+    float *grid = (float *)pool_acquire(gridSize);
+    float *temp = (float *)pool_acquire(gridSize);
+    if (!kernelSpatial || !kernelRange || !columns || !lines || !splatColumns || !splatRows || !grid || !temp) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(kernelSpatial);
+        free(kernelRange);
+        free(columns);
+        free(lines);
+        free(splatColumns);
+        free(splatRows);
+        pool_release(grid);
+        pool_release(temp);
+        return 0;
+    }
+
+    // Unnormalized: the weight channel is blurred alike and divides it out
+    for (int k = -radiusSpatial; k <= radiusSpatial; k++) {
+        kernelSpatial[k + radiusSpatial] = expf(-(float)(k * k) / (2 * sigmaCells * sigmaCells));
+    }
+    for (int k = -radiusRange; k <= radiusRange; k++) {
+        kernelRange[k + radiusRange] = expf(-(float)(k * k) / (2 * rangeCells * rangeCells));
+    }
+    bilateral_spans(columns, splatColumns, width, cellSpatial);
+    bilateral_spans(lines, splatRows, height, cellSpatial);
+    bilateral_spans(values, splatValues, 256, cellRange);
+    args.columns = columns;
+    args.lines = lines;
+    args.values = values;
+    args.splatColumns = splatColumns;
+    args.splatRows = splatRows;
+    args.splatValues = splatValues;
+
+    int grain = scheduler_rowGrain(args.gridWidth * args.gridDepth);
+    args.dst = grid;
+    scheduler_parallelFor(0, args.gridHeight, grain, bilateral_splat, &args);
+
+    args.kernel = kernelSpatial;
+    args.radius = radiusSpatial;
+    args.src = grid;
+    args.dst = temp;
+    scheduler_parallelFor(0, args.gridHeight, grain, bilateral_blurX, &args);
+    args.src = temp;
+    args.dst = grid;
+    scheduler_parallelFor(0, args.gridHeight, grain, bilateral_blurY, &args);
+    args.kernel = kernelRange;
+    args.radius = radiusRange;
+    args.src = grid;
+    args.dst = temp;
+    scheduler_parallelFor(0, args.gridHeight, grain, bilateral_blurZ, &args);
+
+    args.src = temp;
+    scheduler_parallelFor(0, height, scheduler_rowGrain(width), bilateral_slice, &args);
+
+    free(kernelSpatial);
+    free(kernelRange);
+    free(columns);
+    free(lines);
+    free(splatColumns);
+    free(splatRows);
+    pool_release(grid);
+    pool_release(temp);
+    return 1;
+}
@@ -0,0 +1,24 @@
+#ifndef BILATERAL_H
+#define BILATERAL_H
+
+#include <stdint.h>
+
+// Range sigma suited to skin and other smooth gradients, in gray levels
+#define BILATERAL_DEFAULT_RANGE 20.0f
+// Grid cells per sigma; 1 is the classic grid, 2 and up are more accurate
+#define BILATERAL_DEFAULT_SAMPLES 1
+
+// Edge-preserving bilateral smoothing of one 8-bit plane with a bilateral
+// grid (Paris & Durand, 2006). Pixels are accumulated into a 3D grid over
+// x, y and intensity, sampled samplesPerSigma times per sigma along each
+// axis; the grid is blurred with a Gaussian and sliced back at every pixel
+// with trilinear interpolation. The cost depends on the grid size, not on
+// sigmaSpatial, so wide filters are as cheap as narrow ones; narrow ones
+// with many samples need large grids. Each of the two grid buffers is
+// capped at 256 MB: beyond that, spatial cells grow past sigmaSpatial /
+// samplesPerSigma and the filter is approximated more coarsely.
+// Returns 0 on allocation failure.
+int bilateral_grid(uint8_t **rows, int width, int height, float sigmaSpatial, float sigmaRange,
+                   int samplesPerSigma);
+
+#endif // BILATERAL_H
@@ -1,31 +1,50 @@
 #include "bmp24.h"
+#include "bilateral.h"
+#include "clahe.h"
+#include "color.h"
+#include "edges.h"
+#include "fft.h"
+#include "gaussian.h"
+#include "guided.h"
+#include "lut3d.h"
+#include "median.h"
+#include "pool.h"
+#include "pyramid.h"
+#include "quantize.h"
+#include "resize.h"
+#include "rotate.h"
+#include "scheduler.h"
+#include "unsharp.h"
+#include "warp.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 // Memory management functions
+// Pixels live in one pooled block with rows of POOL_ROW_STRIDE(width)
+// pixels; the row pointer array has an extra slot after the last row that
+// keeps the block address for freeing
 t_pixel **bmp24_allocateDataPixels(int width, int height) {
-    t_pixel **pixels = (t_pixel **)malloc(height * sizeof(t_pixel *));
+    t_pixel **pixels = (t_pixel **)malloc((height + 1) * sizeof(t_pixel *));
     if (!pixels) return NULL;
 
+    size_t stride = POOL_ROW_STRIDE((size_t)width);
+    t_pixel *block = (t_pixel *)pool_acquire(stride * height * sizeof(t_pixel));
+    if (!block) {
+        free(pixels);
+        return NULL;
+    }
+
     for (int i = 0; i < height; i++) {
-        pixels[i] = (t_pixel *)malloc(width * sizeof(t_pixel));
-        if (!pixels[i]) {
-            for (int j = 0; j < i; j++) {
-                free(pixels[j]);
-            }
-            free(pixels);
-            return NULL;
-        }
+        pixels[i] = block + (size_t)i * stride;
     }
+    pixels[height] = block;
     return pixels;
 }
 
 void bmp24_freeDataPixels(t_pixel **pixels, int height) {
     if (pixels) {
-        for (int i = 0; i < height; i++) {
-            free(pixels[i]);
-        }
+        pool_release(pixels[height]);
         free(pixels);
     }
 }
@@ -37,6 +56,7 @@ t_bmp24 *bmp24_allocate(int width, int height, int colorDepth) {
     img->width = width;
     img->height = height;
     img->colorDepth = colorDepth;
+    img->stride = POOL_ROW_STRIDE(width);
     img->data = bmp24_allocateDataPixels(width, height);
 
     if (!img->data) {
@@ -65,12 +85,41 @@ void file_rawWrite(uint32_t position, void *buffer, uint32_t size, size_t n, FIL
     fwrite(buffer, size, n, file);
 }
 
+// Size in bytes of one row of pixel data in the file, padded to 4 bytes
+static uint32_t bmp24_rowSize(int width) {
+    return ((uint32_t)width * 3 + 3) & ~3u;
+}
+
+void bmp24_initHeaders(t_bmp24 *img) {
+    if (!img) return;
+
+    uint32_t imageSize = bmp24_rowSize(img->width) * img->height;
+    img->header.type = BMP_TYPE;
+    img->header.size = HEADER_SIZE + INFO_SIZE + imageSize;
+    img->header.reserved1 = 0;
+    img->header.reserved2 = 0;
+    img->header.offset = HEADER_SIZE + INFO_SIZE;
+
+    img->header_info.size = INFO_SIZE;
+    img->header_info.width = img->width;
+    img->header_info.height = img->height;
+    img->header_info.planes = 1;
+    img->header_info.bits = DEFAULT_DEPTH;
+    img->header_info.compression = 0;
+    img->header_info.imagesize = imageSize;
+    // 72 DPI
+    img->header_info.xresolution = 2835;
+    img->header_info.yresolution = 2835;
+    img->header_info.ncolors = 0;
+    img->header_info.importantcolors = 0;
+}
+
 void bmp24_readPixelValue(t_bmp24 *image, int x, int y, FILE *file) {
     if (!image || !file || x < 0 || x >= image->width || y < 0 || y >= image->height) {
         return;
     }
 
-    uint32_t offset = BITMAP_OFFSET + (image->height - 1 - y) * image->width * 3 + x * 3;
+    uint32_t offset = image->header.offset + (image->height - 1 - y) * bmp24_rowSize(image->width) + x * 3;
     fseek(file, offset, SEEK_SET);
 
     // Read BGR order
@@ -82,11 +131,25 @@ void bmp24_readPixelValue(t_bmp24 *image, int x, int y, FILE *file) {
 void bmp24_readPixelData(t_bmp24 *image, FILE *file) {
     if (!image || !file) return;
 
-    for (int y = 0; y < image->height; y++) {
+    // Read whole rows at once instead of seeking to every pixel
+    uint32_t rowSize = bmp24_rowSize(image->width);
+    uint8_t *row = (uint8_t *)malloc(rowSize);
+    if (!row) return;
+
+    fseek(file, image->header.offset, SEEK_SET);
+    for (int y = image->height - 1; y >= 0; y--) {
+        if (fread(row, 1, rowSize, file) != rowSize) {
+            fprintf(stderr, "Error: Could not read image data\n");
+            break;
+        }
         for (int x = 0; x < image->width; x++) {
-            bmp24_readPixelValue(image, x, y, file);
+            image->data[y][x].blue = row[x * 3];
+            image->data[y][x].green = row[x * 3 + 1];
+            image->data[y][x].red = row[x * 3 + 2];
         }
     }
+
+    free(row);
 }
 
 void bmp24_writePixelValue(t_bmp24 *image, int x, int y, FILE *file) {
@@ -94,7 +157,7 @@ void bmp24_writePixelValue(t_bmp24 *image, int x, int y, FILE *file) {
         return;
     }
 
-    uint32_t offset = BITMAP_OFFSET + (image->height - 1 - y) * image->width * 3 + x * 3;
+    uint32_t offset = image->header.offset + (image->height - 1 - y) * bmp24_rowSize(image->width) + x * 3;
     fseek(file, offset, SEEK_SET);
 
     // Write BGR order
@@ -103,14 +166,50 @@ void bmp24_writePixelValue(t_bmp24 *image, int x, int y, FILE *file) {
     fwrite(&image->data[y][x].red, 1, 1, file);
 }
 
-void bmp24_writePixelData(t_bmp24 *image, FILE *file) {
-    if (!image || !file) return;
+int bmp24_writePixelData(t_bmp24 *image, FILE *file) {
+    if (!image || !file) return 0;
 
-    for (int y = 0; y < image->height; y++) {
+    uint32_t rowSize = bmp24_rowSize(image->width);
+    uint8_t *row = (uint8_t *)calloc(rowSize, 1);
+    if (!row) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 0;
+    }
+
+    fseek(file, image->header.offset, SEEK_SET);
+    for (int y = image->height - 1; y >= 0; y--) {
         for (int x = 0; x < image->width; x++) {
-            bmp24_writePixelValue(image, x, y, file);
+            row[x * 3] = image->data[y][x].blue;
+            row[x * 3 + 1] = image->data[y][x].green;
+            row[x * 3 + 2] = image->data[y][x].red;
+        }
+        if (fwrite(row, 1, rowSize, file) != rowSize) {
+            fprintf(stderr, "Error: Could not write image data\n");
+            free(row);
+            return 0;
         }
     }
+
+    free(row);
+    return 1;
+}
+
+// Header fields are read one by one: t_bmp_header is not packed, so its
+// in-memory layout does not match the 14 bytes stored in the file
+static void bmp24_readHeader(t_bmp_header *header, FILE *file) {
+    file_rawRead(BITMAP_MAGIC, &header->type, sizeof(uint16_t), 1, file);
+    file_rawRead(BITMAP_SIZE, &header->size, sizeof(uint32_t), 1, file);
+    file_rawRead(BITMAP_SIZE + 4, &header->reserved1, sizeof(uint16_t), 1, file);
+    file_rawRead(BITMAP_SIZE + 6, &header->reserved2, sizeof(uint16_t), 1, file);
+    file_rawRead(BITMAP_OFFSET, &header->offset, sizeof(uint32_t), 1, file);
+}
+
+static void bmp24_writeHeader(t_bmp_header *header, FILE *file) {
+    file_rawWrite(BITMAP_MAGIC, &header->type, sizeof(uint16_t), 1, file);
+    file_rawWrite(BITMAP_SIZE, &header->size, sizeof(uint32_t), 1, file);
+    file_rawWrite(BITMAP_SIZE + 4, &header->reserved1, sizeof(uint16_t), 1, file);
+    file_rawWrite(BITMAP_SIZE + 6, &header->reserved2, sizeof(uint16_t), 1, file);
+    file_rawWrite(BITMAP_OFFSET, &header->offset, sizeof(uint32_t), 1, file);
 }
 
 // Main image processing functions
@@ -123,7 +222,7 @@ t_bmp24 *bmp24_loadImage(const char *filename) {
 
     // Read header
     t_bmp_header header;
-    file_rawRead(BITMAP_MAGIC, &header, sizeof(t_bmp_header), 1, file);
+    bmp24_readHeader(&header, file);
 
     if (header.type != BMP_TYPE) {
         fprintf(stderr, "Error: Not a BMP file\n");
@@ -159,36 +258,46 @@ t_bmp24 *bmp24_loadImage(const char *filename) {
     return img;
 }
 
-void bmp24_saveImage(t_bmp24 *img, const char *filename) {
+int bmp24_saveImage(t_bmp24 *img, const char *filename) {
     if (!img || !filename) {
         fprintf(stderr, "Error: Invalid parameters\n");
-        return;
+        return 0;
     }
 
     FILE *file = fopen(filename, "wb");
     if (!file) {
         fprintf(stderr, "Error: Could not create file %s\n", filename);
-        return;
+        return 0;
     }
 
-    // Write headers
-    file_rawWrite(BITMAP_MAGIC, &img->header, sizeof(t_bmp_header), 1, file);
+    // Write headers; file_rawWrite does not report errors, so the stream's
+    // error flag is checked once everything is written
+    bmp24_writeHeader(&img->header, file);
     file_rawWrite(HEADER_SIZE, &img->header_info, sizeof(t_bmp_info), 1, file);
 
     // Write pixel data
-    bmp24_writePixelData(img, file);
+    if (!bmp24_writePixelData(img, file)) {
+        fclose(file);
+        return 0;
+    }
 
-    fclose(file);
+    int failed = ferror(file);
+    if (fclose(file) != 0 || failed) {
+        fprintf(stderr, "Error: Could not write file %s\n", filename);
+        return 0;
+    }
+    return 1;
 }
 
 // Image processing functions
-void bmp24_negative(t_bmp24 *img) {
-    if (!img || !img->data) {
-        fprintf(stderr, "Error: Invalid image\n");
-        return;
-    }
-
-    for (int y = 0; y < img->height; y++) {
+typedef struct {
+    t_bmp24 *img;
+    int value;
+} t_bmp24_pointArgs;
+
+static void bmp24_negativeRows(void *ctx, int begin, int end) {
+    t_bmp24 *img = ((t_bmp24_pointArgs *)ctx)->img;
+    for (int y = begin; y < end; y++) {
         for (int x = 0; x < img->width; x++) {
             img->data[y][x].red = 255 - img->data[y][x].red;
             img->data[y][x].green = 255 - img->data[y][x].green;
@@ -197,29 +306,50 @@ void bmp24_negative(t_bmp24 *img) {
     }
 }
 
-void bmp24_grayscale(t_bmp24 *img) {
+void bmp24_negative(t_bmp24 *img) {
     if (!img || !img->data) {
         fprintf(stderr, "Error: Invalid image\n");
         return;
     }
 
-    for (int y = 0; y < img->height; y++) {
-        for (int x = 0; x < img->width; x++) {
-            uint8_t gray = (img->data[y][x].red + img->data[y][x].green + img->data[y][x].blue) / 3;
-            img->data[y][x].red = gray;
-            img->data[y][x].green = gray;
-            img->data[y][x].blue = gray;
+    t_bmp24_pointArgs args = {img, 0};
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp24_negativeRows, &args);
+}
+
+// Weighted BT.601 luma, computed a chunk of pixels at a time
+static void bmp24_grayscaleRows(void *ctx, int begin, int end) {
+    t_bmp24 *img = ((t_bmp24_pointArgs *)ctx)->img;
+    uint8_t gray[256];
+    for (int y = begin; y < end; y++) {
+        for (int x0 = 0; x0 < img->width; x0 += 256) {
+            int count = img->width - x0 < 256 ? img->width - x0 : 256;
+            t_pixel *pixels = img->data[y] + x0;
+            color_rgbToLuma((const uint8_t *)pixels, gray, count, COLOR_BT601);
+            for (int x = 0; x < count; x++) {
+                pixels[x].red = gray[x];
+                pixels[x].green = gray[x];
+                pixels[x].blue = gray[x];
+            }
         }
     }
 }
 
-void bmp24_brightness(t_bmp24 *img, int value) {
+void bmp24_grayscale(t_bmp24 *img) {
     if (!img || !img->data) {
         fprintf(stderr, "Error: Invalid image\n");
         return;
     }
 
-    for (int y = 0; y < img->height; y++) {
+    t_bmp24_pointArgs args = {img, 0};
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp24_grayscaleRows, &args);
+}
+
+static void bmp24_brightnessRows(void *ctx, int begin, int end) {
+    t_bmp24_pointArgs *args = (t_bmp24_pointArgs *)ctx;
+    t_bmp24 *img = args->img;
+    int value = args->value;
+
+    for (int y = begin; y < end; y++) {
         for (int x = 0; x < img->width; x++) {
             int new_red = img->data[y][x].red + value;
             int new_green = img->data[y][x].green + value;
@@ -232,6 +362,16 @@ void bmp24_brightness(t_bmp24 *img, int value) {
     }
 }
 
+void bmp24_brightness(t_bmp24 *img, int value) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return;
+    }
+
+    t_bmp24_pointArgs args = {img, value};
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp24_brightnessRows, &args);
+}
+
 t_pixel bmp24_convolution(t_bmp24 *img, int x, int y, float **kernel, int kernelSize) {
     t_pixel result = {0, 0, 0};
     if (!img || !img->data || !kernel || kernelSize % 2 == 0) {
@@ -262,36 +402,83 @@ t_pixel bmp24_convolution(t_bmp24 *img, int x, int y, float **kernel, int kernel
     return result;
 }
 
+// Row pointers as interleaved bytes, for the kernels shared with bmp8
+static uint8_t **bmp24_rowPointers(t_bmp24 *img) {
+    uint8_t **rows = (uint8_t **)malloc(img->height * sizeof(uint8_t *));
+    if (!rows) return NULL;
+    for (int y = 0; y < img->height; y++) {
+        rows[y] = (uint8_t *)img->data[y];
+    }
+    return rows;
+}
+
 // Filter functions
-void bmp24_boxBlur(t_bmp24 *img) {
-    float kernel[3][3] = {
-        {1.0f/9, 1.0f/9, 1.0f/9},
-        {1.0f/9, 1.0f/9, 1.0f/9},
-        {1.0f/9, 1.0f/9, 1.0f/9}
-    };
+typedef struct {
+    t_bmp24 *img;
+    t_pixel **temp;
+    float **kernel;
+    int kernelSize;
+} t_bmp24_kernelArgs;
+
+static void bmp24_kernelRows(void *ctx, int begin, int end) {
+    t_bmp24_kernelArgs *args = (t_bmp24_kernelArgs *)ctx;
+    int halfSize = args->kernelSize / 2;
+    for (int y = begin; y < end; y++) {
+        for (int x = halfSize; x < args->img->width - halfSize; x++) {
+            args->temp[y][x] = bmp24_convolution(args->img, x, y, args->kernel, args->kernelSize);
+        }
+    }
+}
 
-    float **kernel_ptr = (float **)malloc(3 * sizeof(float *));
-    for (int i = 0; i < 3; i++) {
-        kernel_ptr[i] = kernel[i];
+// Applies a kernel to every pixel at least half a kernel away from the
+// border, rows in parallel
+void bmp24_applyFilter(t_bmp24 *img, float **kernel, int kernelSize) {
+    if (!img || !img->data || !kernel || kernelSize % 2 == 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
     }
 
+    // Large kernels go through the FFT, one plane per color channel
+    if (kernelSize >= fft_crossover()) {
+        uint8_t **rows = bmp24_rowPointers(img);
+        int done = rows && fft_correlate(rows, img->width, img->height, 3, kernel, kernelSize);
+        free(rows);
+        if (done) return;
+    }
+
+    int halfSize = kernelSize / 2;
     t_pixel **temp = bmp24_allocateDataPixels(img->width, img->height);
     if (!temp) return;
 
-    for (int y = 1; y < img->height - 1; y++) {
-        for (int x = 1; x < img->width - 1; x++) {
-            temp[y][x] = bmp24_convolution(img, x, y, kernel_ptr, 3);
-        }
-    }
+    t_bmp24_kernelArgs args = {img, temp, kernel, kernelSize};
+    scheduler_parallelFor(halfSize, img->height - halfSize,
+                          scheduler_rowGrain(img->width * kernelSize * kernelSize),
+                          bmp24_kernelRows, &args);
 
-    for (int y = 1; y < img->height - 1; y++) {
-        for (int x = 1; x < img->width - 1; x++) {
+    for (int y = halfSize; y < img->height - halfSize; y++) {
+        for (int x = halfSize; x < img->width - halfSize; x++) {
             img->data[y][x] = temp[y][x];
         }
     }
 
     bmp24_freeDataPixels(temp, img->height);
-    free(kernel_ptr);
+}
+
+static void bmp24_applyKernel3(t_bmp24 *img, float kernel[3][3]) {
+    float *kernel_ptr[3];
+    for (int i = 0; i < 3; i++) {
+        kernel_ptr[i] = kernel[i];
+    }
+    bmp24_applyFilter(img, kernel_ptr, 3);
+}
+
+void bmp24_boxBlur(t_bmp24 *img) {
+    float kernel[3][3] = {
+        {1.0f/9, 1.0f/9, 1.0f/9},
+        {1.0f/9, 1.0f/9, 1.0f/9},
+        {1.0f/9, 1.0f/9, 1.0f/9}
+    };
+    bmp24_applyKernel3(img, kernel);
 }
 
 void bmp24_gaussianBlur(t_bmp24 *img) {
@@ -300,91 +487,320 @@ void bmp24_gaussianBlur(t_bmp24 *img) {
         {2.0f/16, 4.0f/16, 2.0f/16},
         {1.0f/16, 2.0f/16, 1.0f/16}
     };
+    bmp24_applyKernel3(img, kernel);
+}
 
-    float **kernel_ptr = (float **)malloc(3 * sizeof(float *));
-    for (int i = 0; i < 3; i++) {
-        kernel_ptr[i] = kernel[i];
+void bmp24_gaussianBlurSigma(t_bmp24 *img, float sigma) {
+    if (!img || !img->data || sigma <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
     }
 
-    t_pixel **temp = bmp24_allocateDataPixels(img->width, img->height);
-    if (!temp) return;
+    uint8_t **rows = bmp24_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
 
-    for (int y = 1; y < img->height - 1; y++) {
-        for (int x = 1; x < img->width - 1; x++) {
-            temp[y][x] = bmp24_convolution(img, x, y, kernel_ptr, 3);
-        }
+    gaussian_iir(rows, img->width, img->height, 3, sigma);
+    free(rows);
+}
+
+// Each color channel is filtered on its own
+void bmp24_median(t_bmp24 *img, int radius) {
+    if (!img || !img->data || radius < 1) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
     }
 
-    for (int y = 1; y < img->height - 1; y++) {
-        for (int x = 1; x < img->width - 1; x++) {
-            img->data[y][x] = temp[y][x];
-        }
+    uint8_t **rows = bmp24_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
     }
 
-    bmp24_freeDataPixels(temp, img->height);
-    free(kernel_ptr);
+    median_filter(rows, img->width, img->height, 3, radius);
+    free(rows);
 }
 
-void bmp24_outline(t_bmp24 *img) {
-    float kernel[3][3] = {
-        {-1, -1, -1},
-        {-1, 8, -1},
-        {-1, -1, -1}
-    };
+void bmp24_applyLut3d(t_bmp24 *img, const t_lut3d *lut, t_lut3d_interpolation mode) {
+    if (!img || !img->data || !lut) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
 
-    float **kernel_ptr = (float **)malloc(3 * sizeof(float *));
-    for (int i = 0; i < 3; i++) {
-        kernel_ptr[i] = kernel[i];
+    uint8_t **rows = bmp24_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
     }
 
-    t_pixel **temp = bmp24_allocateDataPixels(img->width, img->height);
-    if (!temp) return;
+    lut3d_apply(lut, rows, img->width, img->height, mode);
+    free(rows);
+}
 
-    for (int y = 1; y < img->height - 1; y++) {
-        for (int x = 1; x < img->width - 1; x++) {
-            temp[y][x] = bmp24_convolution(img, x, y, kernel_ptr, 3);
-        }
+t_bmp24 *bmp24_resize(t_bmp24 *img, int width, int height, t_resize_filter filter) {
+    if (!img || !img->data || width <= 0 || height <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return NULL;
     }
 
-    for (int y = 1; y < img->height - 1; y++) {
-        for (int x = 1; x < img->width - 1; x++) {
-            img->data[y][x] = temp[y][x];
-        }
+    t_bmp24 *result = bmp24_allocate(width, height, img->colorDepth);
+    uint8_t **src = bmp24_rowPointers(img);
+    uint8_t **dst = result ? bmp24_rowPointers(result) : NULL;
+    if (!src || !dst) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        bmp24_free(result);
+        free(src);
+        free(dst);
+        return NULL;
     }
 
-    bmp24_freeDataPixels(temp, img->height);
-    free(kernel_ptr);
+    bmp24_initHeaders(result);
+    result->header_info.xresolution = img->header_info.xresolution;
+    result->header_info.yresolution = img->header_info.yresolution;
+    if (!resize_image(src, img->width, img->height, dst, width, height, 3, filter)) {
+        bmp24_free(result);
+        result = NULL;
+    }
+    free(src);
+    free(dst);
+    return result;
 }
 
-void bmp24_emboss(t_bmp24 *img) {
-    float kernel[3][3] = {
-        {-1, 1, 1},
-        {-2, -1, 0},
-        {0, 1, 2}
-    };
+t_pyramid *bmp24_buildPyramid(t_bmp24 *img, int levels, int gaussian) {
+    if (!img || !img->data || levels < 1) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return NULL;
+    }
 
-    float **kernel_ptr = (float **)malloc(3 * sizeof(float *));
-    for (int i = 0; i < 3; i++) {
-        kernel_ptr[i] = kernel[i];
+    uint8_t **rows = bmp24_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
     }
 
-    t_pixel **temp = bmp24_allocateDataPixels(img->width, img->height);
-    if (!temp) return;
+    t_pyramid *pyramid = pyramid_build(rows, img->width, img->height, 3, levels, gaussian);
+    free(rows);
+    return pyramid;
+}
 
-    for (int y = 1; y < img->height - 1; y++) {
-        for (int x = 1; x < img->width - 1; x++) {
-            temp[y][x] = bmp24_convolution(img, x, y, kernel_ptr, 3);
-        }
+t_bmp24 *bmp24_pyramidLevel(const t_pyramid *pyramid, int level) {
+    if (!pyramid || pyramid->channels != 3 || level < 0 || level >= pyramid->count) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return NULL;
     }
 
-    for (int y = 1; y < img->height - 1; y++) {
-        for (int x = 1; x < img->width - 1; x++) {
-            img->data[y][x] = temp[y][x];
-        }
+    const t_pyramid_level *source = &pyramid->levels[level];
+    t_bmp24 *img = bmp24_allocate(source->width, source->height, DEFAULT_DEPTH);
+    if (!img) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
     }
 
-    bmp24_freeDataPixels(temp, img->height);
-    free(kernel_ptr);
+    bmp24_initHeaders(img);
+    for (int y = 0; y < img->height; y++) {
+        memcpy(img->data[y], source->data + (size_t)y * source->stride, (size_t)img->width * sizeof(t_pixel));
+    }
+    return img;
+}
+
+static void bmp24_reverseRows(uint8_t **rows, int height) {
+    for (int y = 0; y < height / 2; y++) {
+        uint8_t *row = rows[y];
+        rows[y] = rows[height - 1 - y];
+        rows[height - 1 - y] = row;
+    }
+}
+
+// Replaces img with its transpose, read bottom-up for a clockwise turn or
+// written bottom-up for a counterclockwise one
+static void bmp24_transposed(t_bmp24 *img, int reverseSrc, int reverseDst) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return;
+    }
+
+    t_bmp24 *result = bmp24_allocate(img->height, img->width, img->colorDepth);
+    uint8_t **src = bmp24_rowPointers(img);
+    uint8_t **dst = result ? bmp24_rowPointers(result) : NULL;
+    if (!src || !dst) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        bmp24_free(result);
+        free(src);
+        free(dst);
+        return;
+    }
+
+    if (reverseSrc) bmp24_reverseRows(src, img->height);
+    if (reverseDst) bmp24_reverseRows(dst, result->height);
+    rotate_transpose(src, dst, img->width, img->height, 3);
+    bmp24_initHeaders(result);
+    result->header_info.xresolution = img->header_info.yresolution;
+    result->header_info.yresolution = img->header_info.xresolution;
+
+    t_bmp24 previous = *img;
+    *img = *result;
+    *result = previous;
+    bmp24_free(result);
+    free(src);
+    free(dst);
+}
+
+// Flipping top to bottom only reverses the row pointers
+static void bmp24_flipRows(t_bmp24 *img) {
+    for (int y = 0; y < img->height / 2; y++) {
+        t_pixel *row = img->data[y];
+        img->data[y] = img->data[img->height - 1 - y];
+        img->data[img->height - 1 - y] = row;
+    }
+}
+
+void bmp24_rotate90(t_bmp24 *img) {
+    bmp24_transposed(img, 1, 0);
+}
+
+void bmp24_rotate180(t_bmp24 *img) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return;
+    }
+
+    bmp24_flipRows(img);
+    bmp24_flipH(img);
+}
+
+void bmp24_rotate270(t_bmp24 *img) {
+    bmp24_transposed(img, 0, 1);
+}
+
+void bmp24_flipH(t_bmp24 *img) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return;
+    }
+
+    uint8_t **rows = bmp24_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    rotate_mirror(rows, img->width, img->height, 3, 1, 0);
+    free(rows);
+}
+
+void bmp24_flipV(t_bmp24 *img) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return;
+    }
+
+    bmp24_flipRows(img);
+}
+
+void bmp24_transpose(t_bmp24 *img) {
+    bmp24_transposed(img, 0, 0);
+}
+
+t_bmp24 *bmp24_warp(t_bmp24 *img, const double matrix[3][3], int width, int height, t_pixel background) {
+    if (!img || !img->data || !matrix || width <= 0 || height <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return NULL;
+    }
+
+    t_bmp24 *result = bmp24_allocate(width, height, img->colorDepth);
+    uint8_t **src = bmp24_rowPointers(img);
+    uint8_t **dst = result ? bmp24_rowPointers(result) : NULL;
+    if (!src || !dst) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        bmp24_free(result);
+        free(src);
+        free(dst);
+        return NULL;
+    }
+
+    bmp24_initHeaders(result);
+    result->header_info.xresolution = img->header_info.xresolution;
+    result->header_info.yresolution = img->header_info.yresolution;
+    uint8_t fill[3] = {background.red, background.green, background.blue};
+    if (!warp_apply(src, img->width, img->height, dst, width, height, 3, matrix, fill)) {
+        bmp24_free(result);
+        result = NULL;
+    }
+    free(src);
+    free(dst);
+    return result;
+}
+
+void bmp24_rotateAngle(t_bmp24 *img, double degrees, t_pixel background) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return;
+    }
+
+    double matrix[3][3];
+    warp_rotation(degrees, img->width, img->height, matrix);
+    t_bmp24 *result = bmp24_warp(img, matrix, img->width, img->height, background);
+    if (!result) return;
+
+    t_bmp24 previous = *img;
+    *img = *result;
+    *result = previous;
+    bmp24_free(result);
+}
+
+// Each channel guides its own smoothing
+void bmp24_guidedFilter(t_bmp24 *img, int radius, float epsilon) {
+    if (!img || !img->data || radius < 1 || epsilon <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    uint8_t **rows = bmp24_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    guided_filter(rows, rows, img->width, img->height, 3, radius, epsilon);
+    free(rows);
+}
+
+// Sharpens by amount * (pixel - Gaussian blur), leaving differences below
+// threshold alone so that flat noisy areas are not amplified
+void bmp24_unsharpMask(t_bmp24 *img, float sigma, float amount, int threshold) {
+    if (!img || !img->data || sigma <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    uint8_t **rows = bmp24_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    unsharp_apply(rows, img->width, img->height, 3, sigma, amount, threshold);
+    free(rows);
+}
+
+void bmp24_outline(t_bmp24 *img) {
+    float kernel[3][3] = {
+        {-1, -1, -1},
+        {-1, 8, -1},
+        {-1, -1, -1}
+    };
+    bmp24_applyKernel3(img, kernel);
+}
+
+void bmp24_emboss(t_bmp24 *img) {
+    float kernel[3][3] = {
+        {-1, 1, 1},
+        {-2, -1, 0},
+        {0, 1, 2}
+    };
+    bmp24_applyKernel3(img, kernel);
 }
 
 void bmp24_sharpen(t_bmp24 *img) {
@@ -393,51 +809,59 @@ void bmp24_sharpen(t_bmp24 *img) {
         {-1, 5, -1},
         {0, -1, 0}
     };
+    bmp24_applyKernel3(img, kernel);
+}
 
-    float **kernel_ptr = (float **)malloc(3 * sizeof(float *));
-    for (int i = 0; i < 3; i++) {
-        kernel_ptr[i] = kernel[i];
+typedef struct {
+    t_bmp24 *img;
+    uint8_t *luma;
+    int stride;
+} t_bmp24_lumaArgs;
+
+static void bmp24_lumaRows(void *ctx, int begin, int end) {
+    t_bmp24_lumaArgs *args = (t_bmp24_lumaArgs *)ctx;
+    for (int y = begin; y < end; y++) {
+        color_rgbToLuma((const uint8_t *)args->img->data[y], args->luma + (size_t)y * args->stride,
+                        args->img->width, COLOR_BT601);
     }
+}
 
-    t_pixel **temp = bmp24_allocateDataPixels(img->width, img->height);
-    if (!temp) return;
-
-    for (int y = 1; y < img->height - 1; y++) {
-        for (int x = 1; x < img->width - 1; x++) {
-            temp[y][x] = bmp24_convolution(img, x, y, kernel_ptr, 3);
-        }
+// Puts the new luma back, keeping each pixel's chroma
+static void bmp24_setLumaRows(void *ctx, int begin, int end) {
+    t_bmp24_lumaArgs *args = (t_bmp24_lumaArgs *)ctx;
+    for (int y = begin; y < end; y++) {
+        color_setLuma((uint8_t *)args->img->data[y], args->luma + (size_t)y * args->stride, args->img->width,
+                      COLOR_BT601);
     }
+}
 
-    for (int y = 1; y < img->height - 1; y++) {
-        for (int x = 1; x < img->width - 1; x++) {
-            img->data[y][x] = temp[y][x];
-        }
-    }
+typedef struct {
+    t_bmp24_lumaArgs luma;
+    unsigned int *hist;
+} t_bmp24_equalizeArgs;
 
-    bmp24_freeDataPixels(temp, img->height);
-    free(kernel_ptr);
-}
-// Helper functions for color space conversion
-t_yuv rgb_to_yuv(t_pixel pixel) {
-    t_yuv yuv;
-    yuv.y = 0.299f * pixel.red + 0.587f * pixel.green + 0.114f * pixel.blue;
-    yuv.u = -0.14713f * pixel.red - 0.28886f * pixel.green + 0.436f * pixel.blue;
-    yuv.v = 0.615f * pixel.red - 0.51499f * pixel.green - 0.10001f * pixel.blue;
-    return yuv;
-}
+static void bmp24_lumaHistogramRows(void *ctx, int begin, int end) {
+    t_bmp24_equalizeArgs *args = (t_bmp24_equalizeArgs *)ctx;
+    unsigned int local[256] = {0};
 
-t_pixel yuv_to_rgb(t_yuv yuv) {
-    t_pixel pixel;
-    pixel.red = round(yuv.y + 1.13983f * yuv.v);
-    pixel.green = round(yuv.y - 0.39465f * yuv.u - 0.58060f * yuv.v);
-    pixel.blue = round(yuv.y + 2.03211f * yuv.u);
+    bmp24_lumaRows(&args->luma, begin, end);
+    for (int y = begin; y < end; y++) {
+        const uint8_t *luma = args->luma.luma + (size_t)y * args->luma.stride;
+        for (int x = 0; x < args->luma.img->width; x++) local[luma[x]]++;
+    }
+    for (int i = 0; i < 256; i++) {
+        if (local[i]) __atomic_fetch_add(&args->hist[i], local[i], __ATOMIC_RELAXED);
+    }
+}
 
-    // Clamp values to [0, 255]
-    pixel.red = (pixel.red > 255) ? 255 : (pixel.red < 0) ? 0 : pixel.red;
-    pixel.green = (pixel.green > 255) ? 255 : (pixel.green < 0) ? 0 : pixel.green;
-    pixel.blue = (pixel.blue > 255) ? 255 : (pixel.blue < 0) ? 0 : pixel.blue;
+static void bmp24_equalizedLumaRows(void *ctx, int begin, int end) {
+    t_bmp24_equalizeArgs *args = (t_bmp24_equalizeArgs *)ctx;
 
-    return pixel;
+    for (int y = begin; y < end; y++) {
+        uint8_t *luma = args->luma.luma + (size_t)y * args->luma.stride;
+        for (int x = 0; x < args->luma.img->width; x++) luma[x] = (uint8_t)args->hist[luma[x]];
+    }
+    bmp24_setLumaRows(&args->luma, begin, end);
 }
 
 void bmp24_equalize(t_bmp24 *img) {
@@ -446,39 +870,27 @@ void bmp24_equalize(t_bmp24 *img) {
         return;
     }
 
-    // Allocate arrays for YUV values and histogram
-    t_yuv **yuv_data = (t_yuv **)malloc(img->height * sizeof(t_yuv *));
+    // Only the luma plane is kept, pooled; chroma is recomputed from the
+    // untouched pixels when the new luma is put back
+    t_bmp24_equalizeArgs args = {{img, NULL, POOL_ROW_STRIDE(img->width)}, NULL};
+    args.luma.luma = (uint8_t *)pool_acquire((size_t)args.luma.stride * img->height);
     unsigned int *hist = (unsigned int *)calloc(256, sizeof(unsigned int));
-    if (!yuv_data || !hist) {
+    if (!args.luma.luma || !hist) {
         fprintf(stderr, "Error: Memory allocation failed\n");
-        if (yuv_data) free(yuv_data);
-        if (hist) free(hist);
+        pool_release(args.luma.luma);
+        free(hist);
         return;
     }
 
-    // Convert RGB to YUV and compute histogram of Y component
-    for (int y = 0; y < img->height; y++) {
-        yuv_data[y] = (t_yuv *)malloc(img->width * sizeof(t_yuv));
-        if (!yuv_data[y]) {
-            fprintf(stderr, "Error: Memory allocation failed\n");
-            for (int i = 0; i < y; i++) free(yuv_data[i]);
-            free(yuv_data);
-            free(hist);
-            return;
-        }
-
-        for (int x = 0; x < img->width; x++) {
-            yuv_data[y][x] = rgb_to_yuv(img->data[y][x]);
-            hist[(int)round(yuv_data[y][x].y)]++;
-        }
-    }
+    // Compute luma and its histogram
+    args.hist = hist;
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp24_lumaHistogramRows, &args);
 
     // Compute CDF
     unsigned int *cdf = (unsigned int *)malloc(256 * sizeof(unsigned int));
     if (!cdf) {
         fprintf(stderr, "Error: Memory allocation failed\n");
-        for (int y = 0; y < img->height; y++) free(yuv_data[y]);
-        free(yuv_data);
+        pool_release(args.luma.luma);
         free(hist);
         return;
     }
@@ -502,8 +914,7 @@ void bmp24_equalize(t_bmp24 *img) {
     unsigned int *hist_eq = (unsigned int *)malloc(256 * sizeof(unsigned int));
     if (!hist_eq) {
         fprintf(stderr, "Error: Memory allocation failed\n");
-        for (int y = 0; y < img->height; y++) free(yuv_data[y]);
-        free(yuv_data);
+        pool_release(args.luma.luma);
         free(hist);
         free(cdf);
         return;
@@ -517,21 +928,223 @@ void bmp24_equalize(t_bmp24 *img) {
         }
     }
 
-    // Apply equalization to Y component and convert back to RGB
+    // Apply equalization to the luma and put it back
+    args.hist = hist_eq;
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp24_equalizedLumaRows, &args);
+
+    // Free allocated memory
+    pool_release(args.luma.luma);
+    free(hist);
+    free(cdf);
+    free(hist_eq);
+}
+
+// CLAHE on the luma only, so colors keep their hue; only a one-byte luma
+// plane is kept, chroma is recomputed from the untouched pixels
+void bmp24_clahe(t_bmp24 *img, int tilesX, int tilesY, float clipLimit) {
+    if (!img || !img->data || tilesX < 1 || tilesY < 1) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    t_bmp24_lumaArgs args = {img, NULL, POOL_ROW_STRIDE(img->width)};
+    args.luma = (uint8_t *)pool_acquire((size_t)args.stride * img->height);
+    uint8_t **rows = (uint8_t **)malloc(img->height * sizeof(uint8_t *));
+    if (!args.luma || !rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        pool_release(args.luma);
+        free(rows);
+        return;
+    }
     for (int y = 0; y < img->height; y++) {
-        for (int x = 0; x < img->width; x++) {
-            int y_value = (int)round(yuv_data[y][x].y);
-            yuv_data[y][x].y = hist_eq[y_value];
-            img->data[y][x] = yuv_to_rgb(yuv_data[y][x]);
+        rows[y] = args.luma + (size_t)y * args.stride;
+    }
+
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp24_lumaRows, &args);
+    if (clahe_apply(rows, img->width, img->height, tilesX, tilesY, clipLimit)) {
+        scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp24_setLumaRows, &args);
+    }
+
+    pool_release(args.luma);
+    free(rows);
+}
+
+// The luma plane is written straight into the new image's rows
+t_bmp8 *bmp24_toBmp8(const t_bmp24 *img) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return NULL;
+    }
+
+    t_bmp8 *luma = bmp8_allocate(img->width, img->height);
+    if (!luma) return NULL;
+
+    t_bmp24_lumaArgs args = {(t_bmp24 *)img, luma->data, (int)luma->stride};
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp24_lumaRows, &args);
+    return luma;
+}
+
+t_bmp8 *bmp24_toBmp8Dither(const t_bmp24 *img, int levels, t_dither_method method) {
+    if (levels < 2 || levels > 256) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return NULL;
+    }
+
+    t_bmp8 *gray = bmp24_toBmp8(img);
+    if (gray) bmp8_dither(gray, levels, method);
+    return gray;
+}
+
+// Palette and indexes are both computed from the pixels, see quantize.h
+t_bmp8 *bmp24_quantize(t_bmp24 *img, int ncolors) {
+    if (!img || !img->data || ncolors < 1 || ncolors > QUANTIZE_MAX_COLORS) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return NULL;
+    }
+
+    t_bmp8 *result = bmp8_allocate(img->width, img->height);
+    uint8_t **rows = bmp24_rowPointers(img);
+    uint8_t **indexes = (uint8_t **)malloc(img->height * sizeof(uint8_t *));
+    if (!result || !rows || !indexes) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        bmp8_free(result);
+        free(rows);
+        free(indexes);
+        return NULL;
+    }
+    for (int y = 0; y < img->height; y++) {
+        indexes[y] = result->data + (size_t)y * result->stride;
+    }
+
+    uint8_t palette[QUANTIZE_MAX_COLORS][3];
+    int count = quantize_palette(rows, img->width, img->height, ncolors, palette);
+    if (!count || !quantize_map(rows, img->width, img->height, (const uint8_t (*)[3])palette, count, indexes)) {
+        bmp8_free(result);
+        result = NULL;
+    } else {
+        // Palette entries are stored as blue, green, red and a reserved byte
+        memset(result->colorTable, 0, sizeof(result->colorTable));
+        for (int i = 0; i < count; i++) {
+            result->colorTable[4 * i] = palette[i][2];
+            result->colorTable[4 * i + 1] = palette[i][1];
+            result->colorTable[4 * i + 2] = palette[i][0];
         }
     }
 
-    // Free allocated memory
+    free(rows);
+    free(indexes);
+    return result;
+}
+
+typedef struct {
+    const t_bmp8 *gray;
+    t_bmp24 *img;
+    t_pixel palette[256];
+} t_bmp24_expandArgs;
+
+static void bmp24_expandRows(void *ctx, int begin, int end) {
+    const t_bmp24_expandArgs *args = (const t_bmp24_expandArgs *)ctx;
+    for (int y = begin; y < end; y++) {
+        const uint8_t *src = args->gray->data + (size_t)y * args->gray->stride;
+        t_pixel *dst = args->img->data[y];
+        for (int x = 0; x < args->img->width; x++) dst[x] = args->palette[src[x]];
+    }
+}
+
+// Indexes are looked up in the palette, which need not be gray
+t_bmp24 *bmp8_toBmp24(const t_bmp8 *img) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return NULL;
+    }
+
+    t_bmp24_expandArgs *args = (t_bmp24_expandArgs *)malloc(sizeof(t_bmp24_expandArgs));
+    t_bmp24 *result = bmp24_allocate((int)img->width, (int)img->height, 24);
+    if (!args || !result) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(args);
+        bmp24_free(result);
+        return NULL;
+    }
+
+    bmp24_initHeaders(result);
+    args->gray = img;
+    args->img = result;
+    for (int i = 0; i < 256; i++) {
+        args->palette[i].blue = img->colorTable[4 * i];
+        args->palette[i].green = img->colorTable[4 * i + 1];
+        args->palette[i].red = img->colorTable[4 * i + 2];
+    }
+    scheduler_parallelFor(0, result->height, scheduler_rowGrain(result->width), bmp24_expandRows, args);
+    free(args);
+    return result;
+}
+
+t_bmp8 *bmp24_sobel(t_bmp24 *img) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return NULL;
+    }
+
+    t_bmp8 *luma = bmp24_toBmp8(img);
+    t_bmp8 *edges = luma ? bmp8_sobel(luma) : NULL;
+    bmp8_free(luma);
+    return edges;
+}
+
+t_bmp8 *bmp24_canny(t_bmp24 *img, float sigma, int low, int high) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return NULL;
+    }
+
+    t_bmp8 *luma = bmp24_toBmp8(img);
+    t_bmp8 *edges = luma ? bmp8_canny(luma, sigma, low, high) : NULL;
+    bmp8_free(luma);
+    return edges;
+}
+
+// Smooths the luma only, so that colors are not blended across edges
+void bmp24_bilateral(t_bmp24 *img, float sigmaSpatial, float sigmaRange, int samplesPerSigma) {
+    if (!img || !img->data || sigmaSpatial <= 0 || sigmaRange <= 0 || samplesPerSigma < 1) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    t_bmp8 *luma = bmp24_toBmp8(img);
+    uint8_t **rows = (uint8_t **)malloc(img->height * sizeof(uint8_t *));
+    if (!luma || !rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        bmp8_free(luma);
+        free(rows);
+        return;
+    }
     for (int y = 0; y < img->height; y++) {
-        free(yuv_data[y]);
+        rows[y] = luma->data + (size_t)y * luma->stride;
     }
-    free(yuv_data);
-    free(hist);
-    free(cdf);
-    free(hist_eq);
-}
\ No newline at end of file
+
+    if (bilateral_grid(rows, img->width, img->height, sigmaSpatial, sigmaRange, samplesPerSigma)) {
+        t_bmp24_lumaArgs args = {img, luma->data, (int)luma->stride};
+        scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp24_setLumaRows, &args);
+    }
+
+    bmp8_free(luma);
+    free(rows);
+}
+
+t_integral *bmp24_integral(t_bmp24 *img, int withSquares) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return NULL;
+    }
+
+    uint8_t **rows = bmp24_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    t_integral *table = integral_build(rows, img->width, img->height, 3, withSquares);
+    free(rows);
+    return table;
+}
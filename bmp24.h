@@ -4,6 +4,12 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "bmp8.h"
+#include "integral.h"
+#include "lut3d.h"
+#include "pyramid.h"
+#include "resize.h"
+#include "warp.h"
 
 // BMP header types
 typedef struct {
@@ -35,20 +41,15 @@ typedef struct {
     uint8_t blue;
 } t_pixel;
 
-// YUV color space structure
-typedef struct {
-    float y;  // Luminance
-    float u;  // Chrominance U
-    float v;  // Chrominance V
-} t_yuv;
-
-// BMP image structure
+// BMP image structure. Each row of data starts on a 64-byte boundary and
+// holds stride pixels, so kernels may read and write up to stride pixels.
 typedef struct {
     t_bmp_header header;
     t_bmp_info header_info;
     int width;
     int height;
     int colorDepth;
+    int stride;
     t_pixel **data;
 } t_bmp24;
 
@@ -69,6 +70,8 @@ typedef struct {
 t_pixel **bmp24_allocateDataPixels(int width, int height);
 void bmp24_freeDataPixels(t_pixel **pixels, int height);
 t_bmp24 *bmp24_allocate(int width, int height, int colorDepth);
+// Fills the file headers of an uncompressed 24-bit image of img's size
+void bmp24_initHeaders(t_bmp24 *img);
 void bmp24_free(t_bmp24 *img);
 
 // File I/O functions
@@ -77,26 +80,85 @@ void file_rawWrite(uint32_t position, void *buffer, uint32_t size, size_t n, FIL
 void bmp24_readPixelValue(t_bmp24 *image, int x, int y, FILE *file);
 void bmp24_readPixelData(t_bmp24 *image, FILE *file);
 void bmp24_writePixelValue(t_bmp24 *image, int x, int y, FILE *file);
-void bmp24_writePixelData(t_bmp24 *image, FILE *file);
+int bmp24_writePixelData(t_bmp24 *image, FILE *file);
 
 // Main image processing functions
 t_bmp24 *bmp24_loadImage(const char *filename);
-void bmp24_saveImage(t_bmp24 *img, const char *filename);
+// Returns 0 if the file could not be written
+int bmp24_saveImage(t_bmp24 *img, const char *filename);
 
 // Image processing functions
 void bmp24_negative(t_bmp24 *img);
 void bmp24_grayscale(t_bmp24 *img);
 void bmp24_brightness(t_bmp24 *img, int value);
 t_pixel bmp24_convolution(t_bmp24 *img, int x, int y, float **kernel, int kernelSize);
+void bmp24_applyFilter(t_bmp24 *img, float **kernel, int kernelSize);
 
 // Filter functions
 void bmp24_boxBlur(t_bmp24 *img);
 void bmp24_gaussianBlur(t_bmp24 *img);
+void bmp24_gaussianBlurSigma(t_bmp24 *img, float sigma);
+void bmp24_median(t_bmp24 *img, int radius);
 void bmp24_outline(t_bmp24 *img);
 void bmp24_emboss(t_bmp24 *img);
 void bmp24_sharpen(t_bmp24 *img);
+void bmp24_unsharpMask(t_bmp24 *img, float sigma, float amount, int threshold);
+// Edge-preserving smoothing of the luma, see bilateral.h
+void bmp24_bilateral(t_bmp24 *img, float sigmaSpatial, float sigmaRange, int samplesPerSigma);
+// Self-guided filter of every channel, see guided.h
+void bmp24_guidedFilter(t_bmp24 *img, int radius, float epsilon);
 
 // Histogram equalization function
 void bmp24_equalize(t_bmp24 *img);
+// Tiled contrast-limited equalization of the luma, see clahe.h
+void bmp24_clahe(t_bmp24 *img, int tilesX, int tilesY, float clipLimit);
+
+// Maps every pixel through a 3D color table in one pass, see lut3d.h
+void bmp24_applyLut3d(t_bmp24 *img, const t_lut3d *lut, t_lut3d_interpolation mode);
+
+// Resampled copy of the image, see resize.h
+t_bmp24 *bmp24_resize(t_bmp24 *img, int width, int height, t_resize_filter filter);
+
+// Turns clockwise by 90, 180 or 270 degrees, mirrors left to right
+// (flipH) or top to bottom (flipV), or swaps rows and columns, in place;
+// see rotate.h. Flipping top to bottom moves no pixels.
+void bmp24_rotate90(t_bmp24 *img);
+void bmp24_rotate180(t_bmp24 *img);
+void bmp24_rotate270(t_bmp24 *img);
+void bmp24_flipH(t_bmp24 *img);
+void bmp24_flipV(t_bmp24 *img);
+void bmp24_transpose(t_bmp24 *img);
+
+// Copy of the image resampled through matrix, which maps output to source
+// coordinates; uncovered pixels get background. warp_quadToRect gives the
+// matrix that corrects the perspective of a quadrilateral. See warp.h.
+t_bmp24 *bmp24_warp(t_bmp24 *img, const double matrix[3][3], int width, int height, t_pixel background);
+// Turns clockwise by any angle around the center, in place, keeping the
+// image size: the corners are cut off and background fills the gaps
+void bmp24_rotateAngle(t_bmp24 *img, double degrees, t_pixel background);
+
+// Halved copies of the image down to levels times, see pyramid.h; free the
+// result with pyramid_free. bmp24_pyramidLevel copies one level out.
+t_pyramid *bmp24_buildPyramid(t_bmp24 *img, int levels, int gaussian);
+t_bmp24 *bmp24_pyramidLevel(const t_pyramid *pyramid, int level);
+
+// Conversions between the two depths. bmp24_toBmp8 keeps the BT.601
+// luma, as a real 8-bit image with a gray palette, a third of the size;
+// bmp8_toBmp24 looks each index up in the palette.
+t_bmp8 *bmp24_toBmp8(const t_bmp24 *img);
+t_bmp24 *bmp8_toBmp24(const t_bmp8 *img);
+// bmp24_toBmp8 followed by bmp8_dither, for printing color images
+t_bmp8 *bmp24_toBmp8Dither(const t_bmp24 *img, int levels, t_dither_method method);
+// Indexed copy with a palette of at most ncolors (up to 256) colors
+// chosen by median cut, see quantize.h
+t_bmp8 *bmp24_quantize(t_bmp24 *img, int ncolors);
+
+// Edge maps of the luma, returned as 8-bit images; see edges.h
+t_bmp8 *bmp24_sobel(t_bmp24 *img);
+t_bmp8 *bmp24_canny(t_bmp24 *img, float sigma, int low, int high);
+
+// Summed-area table with one interleaved channel per color, with squared
+// sums if requested; release it with integral_free
+t_integral *bmp24_integral(t_bmp24 *img, int withSquares);
 
 #endif // BMP24_H 
\ No newline at end of file
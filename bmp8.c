@@ -1,12 +1,87 @@
 #include <stdio.h>
 #include "bmp8.h"
+#include "bilateral.h"
+#include "clahe.h"
+#include "dither.h"
+#include "edges.h"
+#include "fft.h"
+#include "gaussian.h"
+#include "guided.h"
+#include "median.h"
+#include "morph.h"
+#include "pool.h"
+#include "resize.h"
+#include "rotate.h"
+#include "scheduler.h"
+#include "unsharp.h"
+#include "warp.h"
 #include <string.h>
 #include <stdlib.h>
 
+// Size in bytes of one row of pixel data in the file, padded to 4 bytes
+static unsigned int bmp8_fileRowSize(unsigned int width) {
+    return (width + 3) & ~3u;
+}
+
+static void bmp8_setHeaderField(unsigned char *header, int offset, uint32_t value, int size) {
+    for (int i = 0; i < size; i++) header[offset + i] = (unsigned char)(value >> (8 * i));
+}
+
+t_bmp8 *bmp8_allocate(unsigned int width, unsigned int height) {
+    if (width == 0 || height == 0) {
+        fprintf(stderr, "Error: Invalid image size\n");
+        return NULL;
+    }
+
+    t_bmp8 *img = (t_bmp8 *)malloc(sizeof(t_bmp8));
+    if (!img) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    img->width = width;
+    img->height = height;
+    img->colorDepth = 8;
+    img->dataSize = bmp8_fileRowSize(width) * height;
+    img->stride = POOL_ROW_STRIDE(width);
+    img->data = (unsigned char *)pool_acquire((size_t)img->stride * height);
+    if (!img->data) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(img);
+        return NULL;
+    }
+
+    // Uncompressed 8-bit image with a 256-entry palette at 72 DPI
+    memset(img->header, 0, sizeof(img->header));
+    img->header[0] = 'B';
+    img->header[1] = 'M';
+    bmp8_setHeaderField(img->header, 2, 54 + 1024 + img->dataSize, 4);
+    bmp8_setHeaderField(img->header, 10, 54 + 1024, 4);
+    bmp8_setHeaderField(img->header, 14, 40, 4);
+    bmp8_setHeaderField(img->header, 18, width, 4);
+    bmp8_setHeaderField(img->header, 22, height, 4);
+    bmp8_setHeaderField(img->header, 26, 1, 2);
+    bmp8_setHeaderField(img->header, 28, 8, 2);
+    bmp8_setHeaderField(img->header, 34, img->dataSize, 4);
+    bmp8_setHeaderField(img->header, 38, 2835, 4);
+    bmp8_setHeaderField(img->header, 42, 2835, 4);
+    bmp8_setHeaderField(img->header, 46, 256, 4);
+
+    // Grayscale palette, stored as blue, green, red and a reserved byte
+    for (int i = 0; i < 256; i++) {
+        img->colorTable[4 * i] = (unsigned char)i;
+        img->colorTable[4 * i + 1] = (unsigned char)i;
+        img->colorTable[4 * i + 2] = (unsigned char)i;
+        img->colorTable[4 * i + 3] = 0;
+    }
+
+    return img;
+}
+
 t_bmp8 *bmp8_loadImage(const char *filename) {
     FILE *file = fopen(filename, "rb");
     if (!file) {
-        printf(stderr, "Error: Could not open file %s\n", filename);
+        fprintf(stderr, "Error: Could not open file %s\n", filename);
         return NULL;
     }
 
@@ -36,7 +111,6 @@ t_bmp8 *bmp8_loadImage(const char *filename) {
     img->width = *(unsigned int *)&img->header[18];
     img->height = *(unsigned int *)&img->header[22];
     img->colorDepth = *(unsigned int *)&img->header[28];
-    img->dataSize = *(unsigned int *)&img->header[34];
 
     // Check if image is 8-bit grayscale
     if (img->colorDepth != 8) {
@@ -46,66 +120,83 @@ t_bmp8 *bmp8_loadImage(const char *filename) {
         return NULL;
     }
 
+    // The header's image size may be 0 for uncompressed files
+    unsigned int fileRowSize = bmp8_fileRowSize(img->width);
+    img->dataSize = fileRowSize * img->height;
+    img->stride = POOL_ROW_STRIDE(img->width);
+
     // Allocate memory for image data
-    img->data = (unsigned char *)malloc(img->dataSize);
+    img->data = (unsigned char *)pool_acquire((size_t)img->stride * img->height);
     if (!img->data) {
         fclose(file);
         free(img);
         return NULL;
     }
 
-    // Read image data
-    if (fread(img->data, sizeof(unsigned char), img->dataSize, file) != img->dataSize) {
-        fprintf(stderr, "Error: Could not read image data\n");
-        fclose(file);
-        free(img->data);
-        free(img);
-        return NULL;
+    // Read image data: rows are stored bottom-up in the file and top-down
+    // in memory, each padded to the aligned stride
+    for (unsigned int y = img->height; y-- > 0;) {
+        if (fread(img->data + (size_t)y * img->stride, sizeof(unsigned char), fileRowSize, file) != fileRowSize) {
+            fprintf(stderr, "Error: Could not read image data\n");
+            fclose(file);
+            pool_release(img->data);
+            free(img);
+            return NULL;
+        }
     }
 
     fclose(file);
     return img;
 }
 
-void bmp8_saveImage(const char *filename, t_bmp8 *img) {
+int bmp8_saveImage(const char *filename, t_bmp8 *img) {
     if (!img || !filename) {
         fprintf(stderr, "Error: Invalid parameters\n");
-        return;
+        return 0;
     }
 
     FILE *file = fopen(filename, "wb");
     if (!file) {
         fprintf(stderr, "Error: Could not create file %s\n", filename);
-        return;
+        return 0;
     }
 
     // Write header
     if (fwrite(img->header, sizeof(unsigned char), 54, file) != 54) {
         fprintf(stderr, "Error: Could not write BMP header\n");
         fclose(file);
-        return;
+        return 0;
     }
 
     // Write color table
     if (fwrite(img->colorTable, sizeof(unsigned char), 1024, file) != 1024) {
         fprintf(stderr, "Error: Could not write color table\n");
         fclose(file);
-        return;
+        return 0;
+    }
+
+    // Write image data bottom-up, with zeroed file padding
+    const unsigned char padding[3] = {0, 0, 0};
+    unsigned int paddingSize = bmp8_fileRowSize(img->width) - img->width;
+    for (unsigned int y = img->height; y-- > 0;) {
+        if (fwrite(img->data + (size_t)y * img->stride, sizeof(unsigned char), img->width, file) != img->width ||
+            fwrite(padding, sizeof(unsigned char), paddingSize, file) != paddingSize) {
+            fprintf(stderr, "Error: Could not write image data\n");
+            fclose(file);
+            return 0;
+        }
     }
 
-    // Write image data
-    if (fwrite(img->data, sizeof(unsigned char), img->dataSize, file) != img->dataSize) {
-        fprintf(stderr, "Error: Could not write image data\n");
-        fclose(file);
-        return;
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Error: Could not write file %s\n", filename);
+        return 0;
     }
-
-    fclose(file);
+    return 1;
 }
 
 void bmp8_free(t_bmp8 *img) {
     if (img) {
-        free(img->data);
+        pool_release(img->data);
         free(img);
     }
 }
@@ -123,14 +214,38 @@ void bmp8_printInfo(t_bmp8 *img) {
     printf("Data Size: %u\n", img->dataSize);
 }
 
+static void bmp8_negativeRows(void *ctx, int begin, int end) {
+    t_bmp8 *img = (t_bmp8 *)ctx;
+    for (int y = begin; y < end; y++) {
+        unsigned char *row = img->data + (size_t)y * img->stride;
+        for (unsigned int x = 0; x < img->width; x++) {
+            row[x] = 255 - row[x];
+        }
+    }
+}
+
 void bmp8_negative(t_bmp8 *img) {
     if (!img || !img->data) {
         fprintf(stderr, "Error: Invalid image\n");
         return;
     }
 
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        img->data[i] = 255 - img->data[i];
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp8_negativeRows, img);
+}
+
+typedef struct {
+    t_bmp8 *img;
+    int value;
+} t_bmp8_pointArgs;
+
+static void bmp8_brightnessRows(void *ctx, int begin, int end) {
+    t_bmp8_pointArgs *args = (t_bmp8_pointArgs *)ctx;
+    for (int y = begin; y < end; y++) {
+        unsigned char *row = args->img->data + (size_t)y * args->img->stride;
+        for (unsigned int x = 0; x < args->img->width; x++) {
+            int new_value = row[x] + args->value;
+            row[x] = (new_value > 255) ? 255 : (new_value < 0) ? 0 : new_value;
+        }
     }
 }
 
@@ -140,9 +255,17 @@ void bmp8_brightness(t_bmp8 *img, int value) {
         return;
     }
 
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        int new_value = img->data[i] + value;
-        img->data[i] = (new_value > 255) ? 255 : (new_value < 0) ? 0 : new_value;
+    t_bmp8_pointArgs args = {img, value};
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp8_brightnessRows, &args);
+}
+
+static void bmp8_thresholdRows(void *ctx, int begin, int end) {
+    t_bmp8_pointArgs *args = (t_bmp8_pointArgs *)ctx;
+    for (int y = begin; y < end; y++) {
+        unsigned char *row = args->img->data + (size_t)y * args->img->stride;
+        for (unsigned int x = 0; x < args->img->width; x++) {
+            row[x] = (row[x] >= args->value) ? 255 : 0;
+        }
     }
 }
 
@@ -152,8 +275,45 @@ void bmp8_threshold(t_bmp8 *img, int threshold) {
         return;
     }
 
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        img->data[i] = (img->data[i] >= threshold) ? 255 : 0;
+    t_bmp8_pointArgs args = {img, threshold};
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp8_thresholdRows, &args);
+}
+
+// Row pointers into the pixel data, for the kernels shared with bmp24
+static uint8_t **bmp8_rowPointers(t_bmp8 *img) {
+    uint8_t **rows = (uint8_t **)malloc(img->height * sizeof(uint8_t *));
+    if (!rows) return NULL;
+    for (unsigned int y = 0; y < img->height; y++) {
+        rows[y] = img->data + (size_t)y * img->stride;
+    }
+    return rows;
+}
+
+typedef struct {
+    t_bmp8 *img;
+    const unsigned char *source;
+    float **kernel;
+    int kernelSize;
+} t_bmp8_filterArgs;
+
+static void bmp8_filterRows(void *ctx, int begin, int end) {
+    t_bmp8_filterArgs *args = (t_bmp8_filterArgs *)ctx;
+    t_bmp8 *img = args->img;
+    int halfSize = args->kernelSize / 2;
+
+    for (int y = begin; y < end; y++) {
+        for (int x = halfSize; x < (int)img->width - halfSize; x++) {
+            float sum = 0.0f;
+            for (int ky = -halfSize; ky <= halfSize; ky++) {
+                for (int kx = -halfSize; kx <= halfSize; kx++) {
+                    int pixelX = x + kx;
+                    int pixelY = y + ky;
+                    sum += args->source[pixelY * img->stride + pixelX] *
+                           args->kernel[ky + halfSize][kx + halfSize];
+                }
+            }
+            img->data[y * img->stride + x] = (unsigned char)(sum > 255 ? 255 : (sum < 0 ? 0 : sum));
+        }
     }
 }
 
@@ -163,33 +323,54 @@ void bmp8_applyFilter(t_bmp8 *img, float **kernel, int kernelSize) {
         return;
     }
 
+    // Large kernels are cheaper through the FFT, whose cost barely grows
+    // with the kernel size
+    if (kernelSize >= fft_crossover()) {
+        uint8_t **rows = bmp8_rowPointers(img);
+        int done = rows && fft_correlate(rows, img->width, img->height, 1, kernel, kernelSize);
+        free(rows);
+        if (done) return;
+    }
+
     int halfSize = kernelSize / 2;
-    unsigned char *tempData = (unsigned char *)malloc(img->dataSize);
+    size_t size = (size_t)img->stride * img->height;
+    unsigned char *tempData = (unsigned char *)pool_acquire(size);
     if (!tempData) {
         fprintf(stderr, "Error: Memory allocation failed\n");
         return;
     }
 
-    memcpy(tempData, img->data, img->dataSize);
+    memcpy(tempData, img->data, size);
 
-    for (int y = halfSize; y < img->height - halfSize; y++) {
-        for (int x = halfSize; x < img->width - halfSize; x++) {
-            float sum = 0.0f;
-            for (int ky = -halfSize; ky <= halfSize; ky++) {
-                for (int kx = -halfSize; kx <= halfSize; kx++) {
-                    int pixelX = x + kx;
-                    int pixelY = y + ky;
-                    sum += tempData[pixelY * img->width + pixelX] * 
-                           kernel[ky + halfSize][kx + halfSize];
-                }
-            }
-            img->data[y * img->width + x] = (unsigned char)(sum > 255 ? 255 : (sum < 0 ? 0 : sum));
-        }
-    }
+    t_bmp8_filterArgs args = {img, tempData, kernel, kernelSize};
+    scheduler_parallelFor(halfSize, (int)img->height - halfSize,
+                          scheduler_rowGrain(img->width * kernelSize * kernelSize),
+                          bmp8_filterRows, &args);
 
-    free(tempData);
+    pool_release(tempData);
 }
 // Histogram equalization functions
+typedef struct {
+    t_bmp8 *img;
+    unsigned int *hist;
+} t_bmp8_histogramArgs;
+
+// Counts into a private histogram, then merges it into the shared one
+static void bmp8_histogramRows(void *ctx, int begin, int end) {
+    t_bmp8_histogramArgs *args = (t_bmp8_histogramArgs *)ctx;
+    unsigned int local[256] = {0};
+
+    for (int y = begin; y < end; y++) {
+        const unsigned char *row = args->img->data + (size_t)y * args->img->stride;
+        for (unsigned int x = 0; x < args->img->width; x++) {
+            local[row[x]]++;
+        }
+    }
+    for (int i = 0; i < 256; i++) {
+        if (local[i]) __atomic_fetch_add(&args->hist[i], local[i], __ATOMIC_RELAXED);
+    }
+}
+
 unsigned int *bmp8_computeHistogram(t_bmp8 *img) {
     if (!img || !img->data) {
         fprintf(stderr, "Error: Invalid image\n");
@@ -204,9 +385,8 @@ unsigned int *bmp8_computeHistogram(t_bmp8 *img) {
     }
 
     // Count pixels for each gray level
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        hist[img->data[i]]++;
-    }
+    t_bmp8_histogramArgs args = {img, hist};
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp8_histogramRows, &args);
 
     return hist;
 }
@@ -260,6 +440,16 @@ unsigned int *bmp8_computeCDF(unsigned int *hist) {
     return hist_eq;
 }
 
+static void bmp8_equalizeRows(void *ctx, int begin, int end) {
+    t_bmp8_histogramArgs *args = (t_bmp8_histogramArgs *)ctx;
+    for (int y = begin; y < end; y++) {
+        unsigned char *row = args->img->data + (size_t)y * args->img->stride;
+        for (unsigned int x = 0; x < args->img->width; x++) {
+            row[x] = args->hist[row[x]];
+        }
+    }
+}
+
 void bmp8_equalize(t_bmp8 *img, unsigned int *hist_eq) {
     if (!img || !img->data || !hist_eq) {
         fprintf(stderr, "Error: Invalid parameters\n");
@@ -267,7 +457,488 @@ void bmp8_equalize(t_bmp8 *img, unsigned int *hist_eq) {
     }
 
     // Apply equalization to each pixel
-    for (unsigned int i = 0; i < img->dataSize; i++) {
-        img->data[i] = hist_eq[img->data[i]];
+    t_bmp8_histogramArgs args = {img, hist_eq};
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp8_equalizeRows, &args);
+}
+
+void bmp8_gaussianBlurSigma(t_bmp8 *img, float sigma) {
+    if (!img || !img->data || sigma <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    uint8_t **rows = bmp8_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    gaussian_iir(rows, img->width, img->height, 1, sigma);
+    free(rows);
+}
+
+void bmp8_median(t_bmp8 *img, int radius) {
+    if (!img || !img->data || radius < 1) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    uint8_t **rows = bmp8_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    median_filter(rows, img->width, img->height, 1, radius);
+    free(rows);
+}
+
+t_integral *bmp8_integral(t_bmp8 *img, int withSquares) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return NULL;
+    }
+
+    uint8_t **rows = bmp8_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
     }
-}
\ No newline at end of file
+
+    t_integral *table = integral_build(rows, img->width, img->height, 1, withSquares);
+    free(rows);
+    return table;
+}
+
+void bmp8_unsharpMask(t_bmp8 *img, float sigma, float amount, int threshold) {
+    if (!img || !img->data || sigma <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    uint8_t **rows = bmp8_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    unsharp_apply(rows, img->width, img->height, 1, sigma, amount, threshold);
+    free(rows);
+}
+
+void bmp8_bilateral(t_bmp8 *img, float sigmaSpatial, float sigmaRange, int samplesPerSigma) {
+    if (!img || !img->data || sigmaSpatial <= 0 || sigmaRange <= 0 || samplesPerSigma < 1) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    uint8_t **rows = bmp8_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    bilateral_grid(rows, img->width, img->height, sigmaSpatial, sigmaRange, samplesPerSigma);
+    free(rows);
+}
+
+void bmp8_guidedFilter(t_bmp8 *img, int radius, float epsilon) {
+    if (!img || !img->data || radius < 1 || epsilon <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    uint8_t **rows = bmp8_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    guided_filter(rows, rows, img->width, img->height, 1, radius, epsilon);
+    free(rows);
+}
+
+t_bmp8 *bmp8_resize(t_bmp8 *img, unsigned int width, unsigned int height, t_resize_filter filter) {
+    if (!img || !img->data || width == 0 || height == 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return NULL;
+    }
+
+    t_bmp8 *result = bmp8_allocate(width, height);
+    uint8_t **src = bmp8_rowPointers(img);
+    uint8_t **dst = result ? bmp8_rowPointers(result) : NULL;
+    if (!src || !dst) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        bmp8_free(result);
+        free(src);
+        free(dst);
+        return NULL;
+    }
+
+    // Keep the palette, in case it is not a plain gray ramp
+    memcpy(result->colorTable, img->colorTable, sizeof(result->colorTable));
+    if (!resize_image(src, img->width, img->height, dst, width, height, 1, filter)) {
+        bmp8_free(result);
+        result = NULL;
+    }
+    free(src);
+    free(dst);
+    return result;
+}
+
+static void bmp8_reverseRows(uint8_t **rows, int height) {
+    for (int y = 0; y < height / 2; y++) {
+        uint8_t *row = rows[y];
+        rows[y] = rows[height - 1 - y];
+        rows[height - 1 - y] = row;
+    }
+}
+
+// Replaces img with its transpose, read bottom-up for a clockwise turn or
+// written bottom-up for a counterclockwise one
+static void bmp8_transposed(t_bmp8 *img, int reverseSrc, int reverseDst) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return;
+    }
+
+    t_bmp8 *result = bmp8_allocate(img->height, img->width);
+    uint8_t **src = bmp8_rowPointers(img);
+    uint8_t **dst = result ? bmp8_rowPointers(result) : NULL;
+    if (!src || !dst) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        bmp8_free(result);
+        free(src);
+        free(dst);
+        return;
+    }
+
+    if (reverseSrc) bmp8_reverseRows(src, img->height);
+    if (reverseDst) bmp8_reverseRows(dst, result->height);
+    rotate_transpose(src, dst, img->width, img->height, 1);
+    memcpy(result->colorTable, img->colorTable, sizeof(result->colorTable));
+
+    t_bmp8 previous = *img;
+    *img = *result;
+    *result = previous;
+    bmp8_free(result);
+    free(src);
+    free(dst);
+}
+
+static void bmp8_mirror(t_bmp8 *img, int horizontal, int vertical) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return;
+    }
+
+    uint8_t **rows = bmp8_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    rotate_mirror(rows, img->width, img->height, 1, horizontal, vertical);
+    free(rows);
+}
+
+void bmp8_rotate90(t_bmp8 *img) {
+    bmp8_transposed(img, 1, 0);
+}
+
+// Rows are swapped in place, the data being one block with a fixed order
+void bmp8_rotate180(t_bmp8 *img) {
+    bmp8_mirror(img, 1, 1);
+}
+
+void bmp8_rotate270(t_bmp8 *img) {
+    bmp8_transposed(img, 0, 1);
+}
+
+void bmp8_flipH(t_bmp8 *img) {
+    bmp8_mirror(img, 1, 0);
+}
+
+void bmp8_flipV(t_bmp8 *img) {
+    bmp8_mirror(img, 0, 1);
+}
+
+void bmp8_transpose(t_bmp8 *img) {
+    bmp8_transposed(img, 0, 0);
+}
+
+t_bmp8 *bmp8_warp(t_bmp8 *img, const double matrix[3][3], unsigned int width, unsigned int height,
+                  uint8_t background) {
+    if (!img || !img->data || !matrix || width == 0 || height == 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return NULL;
+    }
+
+    t_bmp8 *result = bmp8_allocate(width, height);
+    uint8_t **src = bmp8_rowPointers(img);
+    uint8_t **dst = result ? bmp8_rowPointers(result) : NULL;
+    if (!src || !dst) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        bmp8_free(result);
+        free(src);
+        free(dst);
+        return NULL;
+    }
+
+    memcpy(result->colorTable, img->colorTable, sizeof(result->colorTable));
+    if (!warp_apply(src, img->width, img->height, dst, width, height, 1, matrix, &background)) {
+        bmp8_free(result);
+        result = NULL;
+    }
+    free(src);
+    free(dst);
+    return result;
+}
+
+void bmp8_rotateAngle(t_bmp8 *img, double degrees, uint8_t background) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return;
+    }
+
+    double matrix[3][3];
+    warp_rotation(degrees, img->width, img->height, matrix);
+    t_bmp8 *result = bmp8_warp(img, matrix, img->width, img->height, background);
+    if (!result) return;
+
+    t_bmp8 previous = *img;
+    *img = *result;
+    *result = previous;
+    bmp8_free(result);
+}
+
+// Gradient magnitude, as a new image of the same size
+t_bmp8 *bmp8_sobel(t_bmp8 *img) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return NULL;
+    }
+
+    t_bmp8 *edges = bmp8_allocate(img->width, img->height);
+    uint8_t **src = bmp8_rowPointers(img);
+    uint8_t **dst = edges ? bmp8_rowPointers(edges) : NULL;
+    if (!src || !dst) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        bmp8_free(edges);
+        free(src);
+        free(dst);
+        return NULL;
+    }
+
+    edges_sobel(src, dst, img->width, img->height);
+    free(src);
+    free(dst);
+    return edges;
+}
+
+t_bmp8 *bmp8_canny(t_bmp8 *img, float sigma, int low, int high) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return NULL;
+    }
+
+    t_bmp8 *edges = bmp8_allocate(img->width, img->height);
+    uint8_t **src = bmp8_rowPointers(img);
+    uint8_t **dst = edges ? bmp8_rowPointers(edges) : NULL;
+    if (!src || !dst) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        bmp8_free(edges);
+        free(src);
+        free(dst);
+        return NULL;
+    }
+
+    if (!edges_canny(src, dst, img->width, img->height, sigma, low, high)) {
+        bmp8_free(edges);
+        edges = NULL;
+    }
+    free(src);
+    free(dst);
+    return edges;
+}
+
+void bmp8_clahe(t_bmp8 *img, int tilesX, int tilesY, float clipLimit) {
+    if (!img || !img->data || tilesX < 1 || tilesY < 1) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    uint8_t **rows = bmp8_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    clahe_apply(rows, img->width, img->height, tilesX, tilesY, clipLimit);
+    free(rows);
+}
+
+// Adaptive thresholding
+typedef enum {
+    BMP8_SAUVOLA,
+    BMP8_BRADLEY
+} t_bmp8_adaptiveMethod;
+
+typedef struct {
+    t_bmp8 *img;
+    t_integral *table;
+    int radius;
+    float k;
+    t_bmp8_adaptiveMethod method;
+} t_bmp8_adaptiveArgs;
+
+// Window statistics come from the summed-area tables, so each pixel costs
+// the same for any radius. Windows are clipped to the image.
+static void bmp8_adaptiveRows(void *ctx, int begin, int end) {
+    t_bmp8_adaptiveArgs *args = (t_bmp8_adaptiveArgs *)ctx;
+    int w = args->img->width;
+    int h = args->img->height;
+    int r = args->radius;
+
+    for (int y = begin; y < end; y++) {
+        unsigned char *row = args->img->data + (size_t)y * args->img->stride;
+        int y0 = y - r > 0 ? y - r : 0;
+        int y1 = y + r + 1 < h ? y + r + 1 : h;
+
+        for (int x = 0; x < w; x++) {
+            int x0 = x - r > 0 ? x - r : 0;
+            int x1 = x + r + 1 < w ? x + r + 1 : w;
+            float count = (float)((x1 - x0) * (y1 - y0));
+            float mean = integral_sum(args->table, x0, y0, x1, y1, 0) / count;
+            float threshold;
+
+            if (args->method == BMP8_SAUVOLA) {
+                float variance = integral_sumSquares(args->table, x0, y0, x1, y1, 0) / count - mean * mean;
+                float deviation = variance > 0 ? sqrtf(variance) : 0;
+                threshold = mean * (1.0f + args->k * (deviation / 128.0f - 1.0f));
+            } else {
+                threshold = mean * (1.0f - args->k);
+            }
+            row[x] = row[x] > threshold ? 255 : 0;
+        }
+    }
+}
+
+static void bmp8_adaptiveThreshold(t_bmp8 *img, int radius, float k, t_bmp8_adaptiveMethod method) {
+    if (!img || !img->data || radius < 1) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    t_integral *table = bmp8_integral(img, method == BMP8_SAUVOLA);
+    if (!table) return;
+
+    t_bmp8_adaptiveArgs args = {img, table, radius, k, method};
+    scheduler_parallelFor(0, img->height, scheduler_rowGrain(img->width), bmp8_adaptiveRows, &args);
+    integral_free(table);
+}
+
+// Sauvola: threshold = mean * (1 + k * (stddev / 128 - 1)) over the window,
+// which lowers the threshold in flat regions; k is typically 0.2 to 0.5
+void bmp8_thresholdSauvola(t_bmp8 *img, int radius, float k) {
+    bmp8_adaptiveThreshold(img, radius, k, BMP8_SAUVOLA);
+}
+
+// Bradley: pixels more than t (e.g. 0.15) below the window mean turn black
+void bmp8_thresholdBradley(t_bmp8 *img, int radius, float t) {
+    bmp8_adaptiveThreshold(img, radius, t, BMP8_BRADLEY);
+}
+
+// Otsu: the level that maximizes the variance between the two classes
+int bmp8_otsuThreshold(const unsigned int *hist) {
+    if (!hist) {
+        fprintf(stderr, "Error: Invalid histogram\n");
+        return 128;
+    }
+
+    double total = 0, weightedTotal = 0;
+    for (int i = 0; i < 256; i++) {
+        total += hist[i];
+        weightedTotal += (double)i * hist[i];
+    }
+
+    double below = 0, weightedBelow = 0, best = -1;
+    int level = 128;
+    for (int i = 0; i < 255; i++) {
+        below += hist[i];
+        weightedBelow += (double)i * hist[i];
+        double above = total - below;
+        if (below == 0 || above == 0) continue;
+
+        double difference = weightedBelow / below - (weightedTotal - weightedBelow) / above;
+        double between = below * above * difference * difference;
+        if (between > best) {
+            best = between;
+            // Values up to i form the dark class; bmp8_threshold keeps >= level
+            level = i + 1;
+        }
+    }
+    return level;
+}
+
+void bmp8_thresholdOtsu(t_bmp8 *img) {
+    unsigned int *hist = bmp8_computeHistogram(img);
+    if (!hist) return;
+
+    bmp8_threshold(img, bmp8_otsuThreshold(hist));
+    free(hist);
+}
+
+// Morphology functions
+static void bmp8_morph(t_bmp8 *img, int radiusX, int radiusY, t_morph_op op) {
+    if (!img || !img->data || radiusX < 0 || radiusY < 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    uint8_t **rows = bmp8_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    morph_apply(rows, img->width, img->height, 1, radiusX, radiusY, op);
+    free(rows);
+}
+
+void bmp8_erode(t_bmp8 *img, int radiusX, int radiusY) {
+    bmp8_morph(img, radiusX, radiusY, MORPH_ERODE);
+}
+
+void bmp8_dilate(t_bmp8 *img, int radiusX, int radiusY) {
+    bmp8_morph(img, radiusX, radiusY, MORPH_DILATE);
+}
+
+// Removes bright details smaller than the element
+void bmp8_open(t_bmp8 *img, int radiusX, int radiusY) {
+    bmp8_morph(img, radiusX, radiusY, MORPH_ERODE);
+    bmp8_morph(img, radiusX, radiusY, MORPH_DILATE);
+}
+
+// Fills dark details smaller than the element
+void bmp8_close(t_bmp8 *img, int radiusX, int radiusY) {
+    bmp8_morph(img, radiusX, radiusY, MORPH_DILATE);
+    bmp8_morph(img, radiusX, radiusY, MORPH_ERODE);
+}
+
+// Pixel values are treated as gray levels, as with the gray palette
+void bmp8_dither(t_bmp8 *img, int levels, t_dither_method method) {
+    if (!img || !img->data) {
+        fprintf(stderr, "Error: Invalid image\n");
+        return;
+    }
+
+    uint8_t **rows = bmp8_rowPointers(img);
+    if (!rows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+
+    dither_apply(rows, img->width, img->height, levels, method);
+    free(rows);
+}
@@ -8,7 +8,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include "dither.h"
+#include "integral.h"
+#include "resize.h"
+#include "warp.h"
 
+// Pixel rows are stored top-down, each starting on a 64-byte boundary
 typedef struct {
     unsigned char header[54];
     unsigned char colorTable[1024];
@@ -16,12 +21,16 @@ typedef struct {
     unsigned int width;
     unsigned int height;
     unsigned int colorDepth;
-    unsigned int dataSize;
+    unsigned int dataSize;  // Size of the pixel data in the file
+    unsigned int stride;    // Bytes between rows in data, a multiple of 64
 } t_bmp8;
 
 // Function prototypes
+// New image with a grayscale palette and uninitialized pixels
+t_bmp8 *bmp8_allocate(unsigned int width, unsigned int height);
 t_bmp8 *bmp8_loadImage(const char *filename);
-void bmp8_saveImage(const char *filename, t_bmp8 *img);
+// Returns 0 if the file could not be written
+int bmp8_saveImage(const char *filename, t_bmp8 *img);
 void bmp8_free(t_bmp8 *img);
 void bmp8_printInfo(t_bmp8 *img);
 
@@ -29,10 +38,64 @@ void bmp8_printInfo(t_bmp8 *img);
 void bmp8_negative(t_bmp8 *img);
 void bmp8_brightness(t_bmp8 *img, int value);
 void bmp8_threshold(t_bmp8 *img, int threshold);
+void bmp8_thresholdSauvola(t_bmp8 *img, int radius, float k);
+void bmp8_thresholdBradley(t_bmp8 *img, int radius, float t);
+void bmp8_thresholdOtsu(t_bmp8 *img);
 void bmp8_applyFilter(t_bmp8 *img, float **kernel, int kernelSize);
+void bmp8_gaussianBlurSigma(t_bmp8 *img, float sigma);
+void bmp8_median(t_bmp8 *img, int radius);
+void bmp8_unsharpMask(t_bmp8 *img, float sigma, float amount, int threshold);
+// Edge-preserving smoothing, see bilateral.h
+void bmp8_bilateral(t_bmp8 *img, float sigmaSpatial, float sigmaRange, int samplesPerSigma);
+// Self-guided filter, see guided.h
+void bmp8_guidedFilter(t_bmp8 *img, int radius, float epsilon);
 
 // Histogram equalization functions
 unsigned int *bmp8_computeHistogram(t_bmp8 *img);
 unsigned int *bmp8_computeCDF(unsigned int *hist);
 void bmp8_equalize(t_bmp8 *img, unsigned int *hist_eq);
+// Tiled contrast-limited equalization, see clahe.h
+void bmp8_clahe(t_bmp8 *img, int tilesX, int tilesY, float clipLimit);
+
+// Summed-area table of the image, with squared sums if requested; release
+// it with integral_free
+t_integral *bmp8_integral(t_bmp8 *img, int withSquares);
+
+// Global threshold for a histogram, as used by bmp8_thresholdOtsu
+int bmp8_otsuThreshold(const unsigned int *hist);
+
+// Resampled copy of the image, see resize.h
+t_bmp8 *bmp8_resize(t_bmp8 *img, unsigned int width, unsigned int height, t_resize_filter filter);
+
+// Turns clockwise by 90, 180 or 270 degrees, mirrors left to right
+// (flipH) or top to bottom (flipV), or swaps rows and columns, in place;
+// see rotate.h
+void bmp8_rotate90(t_bmp8 *img);
+void bmp8_rotate180(t_bmp8 *img);
+void bmp8_rotate270(t_bmp8 *img);
+void bmp8_flipH(t_bmp8 *img);
+void bmp8_flipV(t_bmp8 *img);
+void bmp8_transpose(t_bmp8 *img);
+
+// Copy of the image resampled through matrix, which maps output to source
+// coordinates; uncovered pixels get background. See warp.h.
+t_bmp8 *bmp8_warp(t_bmp8 *img, const double matrix[3][3], unsigned int width, unsigned int height,
+                  uint8_t background);
+// Turns clockwise by any angle around the center, in place, keeping the
+// image size: the corners are cut off and background fills the gaps
+void bmp8_rotateAngle(t_bmp8 *img, double degrees, uint8_t background);
+
+// Edge maps, returned as new images; see edges.h for the Canny thresholds
+t_bmp8 *bmp8_sobel(t_bmp8 *img);
+t_bmp8 *bmp8_canny(t_bmp8 *img, float sigma, int low, int high);
+
+// Morphology with a (2 * radiusX + 1) x (2 * radiusY + 1) rectangle
+void bmp8_erode(t_bmp8 *img, int radiusX, int radiusY);
+void bmp8_dilate(t_bmp8 *img, int radiusX, int radiusY);
+void bmp8_open(t_bmp8 *img, int radiusX, int radiusY);
+void bmp8_close(t_bmp8 *img, int radiusX, int radiusY);
+
+// Reduces a grayscale image in place to levels evenly spaced grays, 2 for
+// black and white print; see dither.h
+void bmp8_dither(t_bmp8 *img, int levels, t_dither_method method);
 #endif //BMP8_H
\ No newline at end of file
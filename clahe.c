@@ -0,0 +1,183 @@
+#include "clahe.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Interpolation weights are in 1/256ths
+#define CLAHE_WEIGHT_ONE 256
+
+// Position of a pixel between two tile centers along one axis
+typedef struct {
+    int first;    // Tile whose center is at or before the pixel
+    int second;   // Next tile, or the same one past the last center
+    int weight;   // Weight of the second tile, 0 to CLAHE_WEIGHT_ONE
+} t_clahe_span;
+
+typedef struct {
+    uint8_t **rows;
+    int width;
+    int height;
+    int tilesX;
+    int tilesY;
+    float clipLimit;
+    uint8_t *luts;            // 256 entries per tile, tile rows in order
+    t_clahe_span *columns;
+    t_clahe_span *lines;
+    int failed;
+} t_clahe_args;
+
+// Start of tile t when length is cut into count tiles of near-equal size
+static int clahe_tileStart(int t, int length, int count) {
+    return (int)((long long)t * length / count);
+}
+
+static void clahe_spans(t_clahe_span *spans, int length, int count) {
+    // Tile and pixel centers are doubled to stay integer
+    int first = 0;
+    for (int i = 0; i < length; i++) {
+        while (first + 1 < count &&
+               clahe_tileStart(first + 1, length, count) + clahe_tileStart(first + 2, length, count) <= 2 * i + 1) {
+            first++;
+        }
+
+        int c0 = clahe_tileStart(first, length, count) + clahe_tileStart(first + 1, length, count);
+        spans[i].first = first;
+        if (first + 1 >= count || 2 * i + 1 < c0) {
+            spans[i].second = first;
+            spans[i].weight = 0;
+        } else {
+            int c1 = clahe_tileStart(first + 1, length, count) + clahe_tileStart(first + 2, length, count);
+            spans[i].second = first + 1;
+            spans[i].weight = (2 * i + 1 - c0) * CLAHE_WEIGHT_ONE / (c1 - c0);
+        }
+    }
+}
+
+// Histogram, clipping and lookup table of each tile
+static void clahe_tiles(void *ctx, int begin, int end) {
+    t_clahe_args *args = (t_clahe_args *)ctx;
+
+    for (int t = begin; t < end; t++) {
+        int tx = t % args->tilesX;
+        int ty = t / args->tilesX;
+        int x0 = clahe_tileStart(tx, args->width, args->tilesX);
+        int x1 = clahe_tileStart(tx + 1, args->width, args->tilesX);
+        int y0 = clahe_tileStart(ty, args->height, args->tilesY);
+        int y1 = clahe_tileStart(ty + 1, args->height, args->tilesY);
+        int area = (x1 - x0) * (y1 - y0);
+        unsigned int hist[256] = {0};
+
+        for (int y = y0; y < y1; y++) {
+            const uint8_t *row = args->rows[y];
+            for (int x = x0; x < x1; x++) hist[row[x]]++;
+        }
+
+        if (args->clipLimit > 0) {
+            unsigned int limit = (unsigned int)(args->clipLimit * area / 256);
+            if (limit < 1) limit = 1;
+
+            unsigned int excess = 0;
+            for (int i = 0; i < 256; i++) {
+                if (hist[i] > limit) {
+                    excess += hist[i] - limit;
+                    hist[i] = limit;
+                }
+            }
+
+            // Spread the excess evenly, the remainder over evenly spaced bins
+            unsigned int share = excess / 256;
+            unsigned int rest = excess % 256;
+            for (int i = 0; i < 256; i++) hist[i] += share;
+            if (rest) {
+                int step = 256 / rest;
+                for (int i = 0; i < 256 && rest; i += step, rest--) hist[i]++;
+            }
+        }
+
+        uint8_t *lut = args->luts + (size_t)t * 256;
+        unsigned int sum = 0;
+        for (int i = 0; i < 256; i++) {
+            sum += hist[i];
+            unsigned int value = (unsigned int)(((uint64_t)sum * 255 + area / 2) / area);
+            lut[i] = (uint8_t)(value > 255 ? 255 : value);
+        }
+    }
+}
+
+// For each row the two tile rows are blended into one 16-bit table per
+// tile column, as whole-table vector operations. Each pixel then needs two
+// lookups and one horizontal blend.
+static void clahe_rows(void *ctx, int begin, int end) {
+    t_clahe_args *args = (t_clahe_args *)ctx;
+    int tilesX = args->tilesX;
+
+    uint16_t *rowLuts = (uint16_t *)malloc((size_t)tilesX * 256 * sizeof(uint16_t));
+    if (!rowLuts) {
+        __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    for (int y = begin; y < end; y++) {
+        t_clahe_span line = args->lines[y];
+        const uint8_t *top = args->luts + (size_t)line.first * tilesX * 256;
+        const uint8_t *bottom = args->luts + (size_t)line.second * tilesX * 256;
+        uint16_t wBottom = (uint16_t)line.weight;
+        uint16_t wTop = (uint16_t)(CLAHE_WEIGHT_ONE - line.weight);
+        for (int i = 0; i < tilesX * 256; i++) {
+            rowLuts[i] = (uint16_t)(top[i] * wTop + bottom[i] * wBottom);
+        }
+
+        uint8_t *row = args->rows[y];
+        for (int x = 0; x < args->width; x++) {
+            t_clahe_span column = args->columns[x];
+            uint32_t left = rowLuts[column.first * 256 + row[x]];
+            uint32_t right = rowLuts[column.second * 256 + row[x]];
+            uint32_t value = left * (CLAHE_WEIGHT_ONE - column.weight) + right * column.weight;
+            row[x] = (uint8_t)((value + CLAHE_WEIGHT_ONE * CLAHE_WEIGHT_ONE / 2) >> 16);
+        }
+    }
+
+    free(rowLuts);
+}
+
+int clahe_apply(uint8_t **rows, int width, int height, int tilesX, int tilesY, float clipLimit) {
+    if (!rows || width <= 0 || height <= 0 || tilesX <= 0 || tilesY <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+    // Every tile needs at least one pixel
+    if (tilesX > width) tilesX = width;
+    if (tilesY > height) tilesY = height;
+
+    t_clahe_args args;
+    args.rows = rows;
+    args.width = width;
+    args.height = height;
+    args.tilesX = tilesX;
+    args.tilesY = tilesY;
+    args.clipLimit = clipLimit;
+    args.failed = 0;
+    args.luts = (uint8_t *)malloc((size_t)tilesX * tilesY * 256);
+    args.columns = (t_clahe_span *)malloc(width * sizeof(t_clahe_span));
+    args.lines = (t_clahe_span *)malloc(height * sizeof(t_clahe_span));
+    if (!args.luts || !args.columns || !args.lines) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(args.luts);
+        free(args.columns);
+        free(args.lines);
+        return 0;
+    }
+
+    clahe_spans(args.columns, width, tilesX);
+    clahe_spans(args.lines, height, tilesY);
+
+    scheduler_parallelFor(0, tilesX * tilesY, 1, clahe_tiles, &args);
+    scheduler_parallelFor(0, height, scheduler_rowGrain(width), clahe_rows, &args);
+    if (args.failed) fprintf(stderr, "Error: Memory allocation failed\n");
+
+    free(args.luts);
+    free(args.columns);
+    free(args.lines);
+    return !args.failed;
+}
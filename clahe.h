@@ -0,0 +1,18 @@
+#ifndef CLAHE_H
+#define CLAHE_H
+
+#include <stdint.h>
+
+// Default grid and clip limit, as commonly used for photographs and scans
+#define CLAHE_DEFAULT_TILES 8
+#define CLAHE_DEFAULT_CLIP 2.0f
+
+// Contrast-limited adaptive histogram equalization of one 8-bit plane.
+// The image is cut into tilesX x tilesY tiles, each with its own equalizing
+// lookup table; every histogram bin is clipped to clipLimit times the
+// average bin count first (0 disables clipping) and the excess is spread
+// over all bins. Pixels blend the tables of the four nearest tile centers.
+// Returns 0 on allocation failure.
+int clahe_apply(uint8_t **rows, int width, int height, int tilesX, int tilesY, float clipLimit);
+
+#endif // CLAHE_H
@@ -0,0 +1,362 @@
+#include "color.h"
+#include <math.h>
+#include <string.h>
+
+#define COLOR_BITS 16
+#define COLOR_HALF (1 << (COLOR_BITS - 1))
+// Pixels converted together: channels are separated with 16-byte
+// shuffles, then computed four pixels at a time in 32-bit lanes
+#define COLOR_LANES 16
+
+typedef uint8_t t_color_bytes __attribute__((vector_size(16)));
+typedef int32_t t_color_ints __attribute__((vector_size(16)));
+typedef float t_color_floats __attribute__((vector_size(16)));
+
+// Fixed-point matrices of one standard. Each row of the forward matrix
+// sums to exactly 1 (luma) or 0 (chroma), so grays map to grays.
+typedef struct {
+    int32_t yr, yg, yb;
+    int32_t cbr, cbg, cbb;
+    int32_t crr, crg, crb;
+    int32_t rcr, gcb, gcr, bcb;   // Inverse: chroma terms added to the luma
+} t_color_matrix;
+
+static int32_t color_fixed(double value) {
+    return (int32_t)lround(value * (1 << COLOR_BITS));
+}
+
+static t_color_matrix color_matrix(t_color_standard standard) {
+    double kr = standard == COLOR_BT709 ? 0.2126 : 0.299;
+    double kb = standard == COLOR_BT709 ? 0.0722 : 0.114;
+    double kg = 1.0 - kr - kb;
+    t_color_matrix m;
+
+    m.yr = color_fixed(kr);
+    m.yb = color_fixed(kb);
+    m.yg = (1 << COLOR_BITS) - m.yr - m.yb;
+    m.cbr = color_fixed(-0.5 * kr / (1.0 - kb));
+    m.cbb = color_fixed(0.5);
+    m.cbg = -m.cbr - m.cbb;
+    m.crr = color_fixed(0.5);
+    m.crb = color_fixed(-0.5 * kb / (1.0 - kr));
+    m.crg = -m.crr - m.crb;
+    m.rcr = color_fixed(2.0 * (1.0 - kr));
+    m.gcb = color_fixed(-2.0 * kb * (1.0 - kb) / kg);
+    m.gcr = color_fixed(-2.0 * kr * (1.0 - kr) / kg);
+    m.bcb = color_fixed(2.0 * (1.0 - kb));
+    return m;
+}
+
+// Masks for the shuffles below, all of which map to single SSE2 unpack
+// or pack instructions: interleaving the low halves of two vectors,
+// repeating the high half, joining the low halves, and keeping the even or
+// odd bytes of two vectors
+static const t_color_bytes color_unpackLow = {0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23};
+static const t_color_bytes color_highHalf = {8, 9, 10, 11, 12, 13, 14, 15, 8, 9, 10, 11, 12, 13, 14, 15};
+static const t_color_bytes color_lowHalves = {0, 1, 2, 3, 4, 5, 6, 7, 16, 17, 18, 19, 20, 21, 22, 23};
+static const t_color_bytes color_even = {0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30};
+static const t_color_bytes color_odd = {1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31};
+
+// Separates 16 interleaved pixels into one row of 16 bytes per channel.
+// Each round interleaves halves of the three vectors; four rounds take
+// the bytes from pixel order to channel order.
+static void color_split(const uint8_t *rgb, t_color_bytes v[3]) {
+    memcpy(v, rgb, 3 * sizeof(t_color_bytes));
+
+    for (int round = 0; round < 4; round++) {
+        t_color_bytes high0 = __builtin_shuffle(v[0], color_highHalf);
+        t_color_bytes high1 = __builtin_shuffle(v[1], color_highHalf);
+        t_color_bytes high2 = __builtin_shuffle(v[2], color_highHalf);
+        t_color_bytes next0 = __builtin_shuffle(v[0], high1, color_unpackLow);
+        t_color_bytes next1 = __builtin_shuffle(high0, v[2], color_unpackLow);
+        t_color_bytes next2 = __builtin_shuffle(v[1], high2, color_unpackLow);
+        v[0] = next0;
+        v[1] = next1;
+        v[2] = next2;
+    }
+}
+
+// Inverse of color_split, undoing its rounds one by one
+static void color_merge(t_color_bytes v[3], uint8_t *rgb) {
+    for (int round = 0; round < 4; round++) {
+        t_color_bytes even = __builtin_shuffle(v[2], v[0], color_even);
+        t_color_bytes odd = __builtin_shuffle(v[0], v[2], color_odd);
+        t_color_bytes next0 = __builtin_shuffle(v[0], v[1], color_even);
+        t_color_bytes next2 = __builtin_shuffle(v[1], v[2], color_odd);
+        v[1] = __builtin_shuffle(even, odd, color_lowHalves);
+        v[0] = next0;
+        v[2] = next2;
+    }
+    memcpy(rgb, v, 3 * sizeof(t_color_bytes));
+}
+
+// Widening interleaves each byte with zeros, which land above it in
+// memory order on little-endian machines and below it on big-endian ones
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define COLOR_WIDEN(v, zero, mask) __builtin_shuffle(v, zero, mask)
+#else
+#define COLOR_WIDEN(v, zero, mask) __builtin_shuffle(zero, v, mask)
+#endif
+
+static const t_color_bytes color_unpackHigh = {8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31};
+static const t_color_bytes color_unpackLowPairs = {0, 1, 16, 17, 2, 3, 18, 19, 4, 5, 20, 21, 6, 7, 22, 23};
+static const t_color_bytes color_unpackHighPairs = {8, 9, 24, 25, 10, 11, 26, 27, 12, 13, 28, 29, 14, 15, 30, 31};
+
+// 16 bytes as four vectors of 32-bit lanes
+static void color_widen(t_color_bytes v, t_color_ints out[4]) {
+    const t_color_bytes zero = {0};
+    t_color_bytes low = COLOR_WIDEN(v, zero, color_unpackLow);
+    t_color_bytes high = COLOR_WIDEN(v, zero, color_unpackHigh);
+    out[0] = (t_color_ints)COLOR_WIDEN(low, zero, color_unpackLowPairs);
+    out[1] = (t_color_ints)COLOR_WIDEN(low, zero, color_unpackHighPairs);
+    out[2] = (t_color_ints)COLOR_WIDEN(high, zero, color_unpackLowPairs);
+    out[3] = (t_color_ints)COLOR_WIDEN(high, zero, color_unpackHighPairs);
+}
+
+// Inverse of color_widen, for lanes already in 0..255: the value bytes
+// are picked by keeping even or odd bytes twice
+static t_color_bytes color_narrow(const t_color_ints in[4]) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    const t_color_bytes *pick = &color_even;
+#else
+    const t_color_bytes *pick = &color_odd;
+#endif
+    t_color_bytes low = __builtin_shuffle((t_color_bytes)in[0], (t_color_bytes)in[1], *pick);
+    t_color_bytes high = __builtin_shuffle((t_color_bytes)in[2], (t_color_bytes)in[3], *pick);
+    return __builtin_shuffle(low, high, *pick);
+}
+
+// Lane masks are all ones where true, so selects are ANDs and ORs
+static inline t_color_ints color_select(t_color_ints mask, t_color_ints a, t_color_ints b) {
+    return (a & mask) | (b & ~mask);
+}
+
+// Negative lanes are zeroed; lanes above 255 become all ones, then 255
+static inline t_color_ints color_clamp(t_color_ints value) {
+    value &= ~(value < 0);
+    return (value | (value > 255)) & 255;
+}
+
+static inline t_color_ints color_max(t_color_ints a, t_color_ints b) {
+    return color_select(a > b, a, b);
+}
+
+static inline t_color_ints color_min(t_color_ints a, t_color_ints b) {
+    return color_select(a < b, a, b);
+}
+
+// n / d rounded down for non-negative n below 2^19 and d up to 1530: the
+// float quotient is never close enough to the next integer to round to it
+static inline t_color_ints color_divide(t_color_ints n, t_color_ints d) {
+    return __builtin_convertvector(__builtin_convertvector(n, t_color_floats) /
+                                   __builtin_convertvector(d, t_color_floats), t_color_ints);
+}
+
+// A channel row of 16 pixels, as four vectors of four
+typedef struct {
+    t_color_ints q[4];
+} t_color_channel;
+
+static void color_loadPlane(const uint8_t *plane, t_color_channel *out) {
+    t_color_bytes v;
+    memcpy(&v, plane, sizeof(v));
+    color_widen(v, out->q);
+}
+
+static void color_storePlane(uint8_t *plane, const t_color_channel *in) {
+    t_color_bytes v = color_narrow(in->q);
+    memcpy(plane, &v, sizeof(v));
+}
+
+static void color_loadRgb(const uint8_t *rgb, t_color_channel out[3]) {
+    t_color_bytes v[3];
+    color_split(rgb, v);
+    for (int c = 0; c < 3; c++) color_widen(v[c], out[c].q);
+}
+
+static void color_storeRgb(uint8_t *rgb, const t_color_channel in[3]) {
+    t_color_bytes v[3];
+    for (int c = 0; c < 3; c++) v[c] = color_narrow(in[c].q);
+    color_merge(v, rgb);
+}
+
+static void color_rgbToYcbcrBlock(const uint8_t *rgb, uint8_t *y, uint8_t *cb, uint8_t *cr, const t_color_matrix *m) {
+    const int32_t chromaOffset = (128 << COLOR_BITS) + COLOR_HALF;
+    t_color_channel in[3], outY, outCb, outCr;
+    color_loadRgb(rgb, in);
+
+    for (int i = 0; i < 4; i++) {
+        t_color_ints r = in[0].q[i], g = in[1].q[i], b = in[2].q[i];
+        outY.q[i] = (m->yr * r + m->yg * g + m->yb * b + COLOR_HALF) >> COLOR_BITS;
+        outCb.q[i] = color_clamp((m->cbr * r + m->cbg * g + m->cbb * b + chromaOffset) >> COLOR_BITS);
+        outCr.q[i] = color_clamp((m->crr * r + m->crg * g + m->crb * b + chromaOffset) >> COLOR_BITS);
+    }
+    color_storePlane(y, &outY);
+    color_storePlane(cb, &outCb);
+    color_storePlane(cr, &outCr);
+}
+
+void color_rgbToYcbcr(const uint8_t *rgb, uint8_t *y, uint8_t *cb, uint8_t *cr, int count,
+                      t_color_standard standard) {
+    t_color_matrix m = color_matrix(standard);
+    int i = 0;
+
+    for (; i + COLOR_LANES <= count; i += COLOR_LANES) color_rgbToYcbcrBlock(rgb + 3 * i, y + i, cb + i, cr + i, &m);
+    if (i < count) {
+        uint8_t in[3 * COLOR_LANES] = {0}, outY[COLOR_LANES], outCb[COLOR_LANES], outCr[COLOR_LANES];
+        memcpy(in, rgb + 3 * i, 3 * (count - i));
+        color_rgbToYcbcrBlock(in, outY, outCb, outCr, &m);
+        memcpy(y + i, outY, count - i);
+        memcpy(cb + i, outCb, count - i);
+        memcpy(cr + i, outCr, count - i);
+    }
+}
+
+static void color_ycbcrToRgbBlock(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgb,
+                                  const t_color_matrix *m) {
+    t_color_channel inY, inCb, inCr, out[3];
+    color_loadPlane(y, &inY);
+    color_loadPlane(cb, &inCb);
+    color_loadPlane(cr, &inCr);
+
+    for (int i = 0; i < 4; i++) {
+        t_color_ints luma = (inY.q[i] << COLOR_BITS) + COLOR_HALF;
+        t_color_ints u = inCb.q[i] - 128, v = inCr.q[i] - 128;
+        out[0].q[i] = color_clamp((luma + m->rcr * v) >> COLOR_BITS);
+        out[1].q[i] = color_clamp((luma + m->gcb * u + m->gcr * v) >> COLOR_BITS);
+        out[2].q[i] = color_clamp((luma + m->bcb * u) >> COLOR_BITS);
+    }
+    color_storeRgb(rgb, out);
+}
+
+void color_ycbcrToRgb(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgb, int count,
+                      t_color_standard standard) {
+    t_color_matrix m = color_matrix(standard);
+    int i = 0;
+
+    for (; i + COLOR_LANES <= count; i += COLOR_LANES) color_ycbcrToRgbBlock(y + i, cb + i, cr + i, rgb + 3 * i, &m);
+    if (i < count) {
+        uint8_t inY[COLOR_LANES] = {0}, inCb[COLOR_LANES] = {0}, inCr[COLOR_LANES] = {0}, out[3 * COLOR_LANES];
+        memcpy(inY, y + i, count - i);
+        memcpy(inCb, cb + i, count - i);
+        memcpy(inCr, cr + i, count - i);
+        color_ycbcrToRgbBlock(inY, inCb, inCr, out, &m);
+        memcpy(rgb + 3 * i, out, 3 * (count - i));
+    }
+}
+
+// Scalar: with a single output per pixel, splitting the channels costs
+// more than SSE2's 32-bit vector multiplies save
+void color_rgbToLuma(const uint8_t *rgb, uint8_t *luma, int count, t_color_standard standard) {
+    t_color_matrix m = color_matrix(standard);
+
+    for (int i = 0; i < count; i++) {
+        luma[i] = (uint8_t)((m.yr * rgb[3 * i] + m.yg * rgb[3 * i + 1] + m.yb * rgb[3 * i + 2] + COLOR_HALF) >>
+                            COLOR_BITS);
+    }
+}
+
+static uint8_t color_clampByte(int32_t value) {
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// Scalar too: as vectors it measured no faster
+void color_setLuma(uint8_t *rgb, const uint8_t *luma, int count, t_color_standard standard) {
+    t_color_matrix m = color_matrix(standard);
+
+    for (int i = 0; i < count; i++) {
+        int32_t r = rgb[3 * i], g = rgb[3 * i + 1], b = rgb[3 * i + 2];
+        int32_t delta = (luma[i] << COLOR_BITS) - (m.yr * r + m.yg * g + m.yb * b) + COLOR_HALF;
+        rgb[3 * i] = color_clampByte(((r << COLOR_BITS) + delta) >> COLOR_BITS);
+        rgb[3 * i + 1] = color_clampByte(((g << COLOR_BITS) + delta) >> COLOR_BITS);
+        rgb[3 * i + 2] = color_clampByte(((b << COLOR_BITS) + delta) >> COLOR_BITS);
+    }
+}
+
+static void color_rgbToHsvBlock(const uint8_t *rgb, uint8_t *hsv) {
+    t_color_channel pixels[3];
+    color_loadRgb(rgb, pixels);
+
+    for (int i = 0; i < 4; i++) {
+        t_color_ints r = pixels[0].q[i], g = pixels[1].q[i], b = pixels[2].q[i];
+        t_color_ints max = color_max(color_max(r, g), b);
+        t_color_ints delta = max - color_min(color_min(r, g), b);
+        t_color_ints colored = delta != 0;
+
+        // Position around the hexagon in units of delta, 6 per turn, from
+        // the largest channel (red first, then green)
+        t_color_ints isRed = max == r;
+        t_color_ints isGreen = ~isRed & (max == g);
+        t_color_ints position = color_select(isRed, g - b + ((g < b) & (6 * delta)),
+                                             color_select(isGreen, 2 * delta + b - r, 4 * delta + r - g));
+        // Gray lanes divide by one and are zeroed afterwards
+        pixels[0].q[i] = color_divide(position * 256 + 3 * delta, 6 * delta + (~colored & 1)) & 255 & colored;
+        pixels[1].q[i] = color_divide(delta * 255 + (max >> 1), max + ((max == 0) & 1)) & colored;
+        pixels[2].q[i] = max;
+    }
+    color_storeRgb(hsv, pixels);
+}
+
+void color_rgbToHsv(const uint8_t *rgb, uint8_t *hsv, int count) {
+    int i = 0;
+
+    for (; i + COLOR_LANES <= count; i += COLOR_LANES) color_rgbToHsvBlock(rgb + 3 * i, hsv + 3 * i);
+    if (i < count) {
+        uint8_t pixels[3 * COLOR_LANES] = {0};
+        memcpy(pixels, rgb + 3 * i, 3 * (count - i));
+        color_rgbToHsvBlock(pixels, pixels);
+        memcpy(hsv + 3 * i, pixels, 3 * (count - i));
+    }
+}
+
+// Scalar: its five 32-bit products per pixel take several instructions
+// each in SSE2 vectors, and a vector version ran slower than this loop
+void color_hsvToRgb(const uint8_t *hsv, uint8_t *rgb, int count) {
+    for (int i = 0; i < count; i++) {
+        int hue = hsv[3 * i] * 6, s = hsv[3 * i + 1], v = hsv[3 * i + 2];
+        int sector = hue >> 8;
+        int f = hue & 255;
+        // Lowest channel, then the falling and rising ones of the sector
+        int p = (v * (255 - s) + 127) / 255;
+        int q = (v * (255 * 256 - s * f) + 32640) / 65280;
+        int t = (v * (255 * 256 - s * (256 - f)) + 32640) / 65280;
+        int r, g, b;
+
+        switch (sector) {
+            case 0:
+                r = v;
+                g = t;
+                b = p;
+                break;
+            case 1:
+                r = q;
+                g = v;
+                b = p;
+                break;
+            case 2:
+                r = p;
+                g = v;
+                b = t;
+                break;
+            case 3:
+                r = p;
+                g = q;
+                b = v;
+                break;
+            case 4:
+                r = t;
+                g = p;
+                b = v;
+                break;
+            default:
+                r = v;
+                g = p;
+                b = q;
+                break;
+        }
+
+        rgb[3 * i] = (uint8_t)r;
+        rgb[3 * i + 1] = (uint8_t)g;
+        rgb[3 * i + 2] = (uint8_t)b;
+    }
+}
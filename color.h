@@ -0,0 +1,36 @@
+#ifndef COLOR_H
+#define COLOR_H
+
+#include <stdint.h>
+
+// Luma weights: BT.601 for standard-definition and JPEG images, BT.709
+// for high-definition video
+typedef enum {
+    COLOR_BT601,
+    COLOR_BT709
+} t_color_standard;
+
+// Row kernels over count pixels of interleaved red, green, blue, in 16.16
+// fixed point; a whole plane is one row when its rows are contiguous. The
+// YCbCr conversions and color_rgbToHsv run 16 pixels at a time on GCC
+// vector types, the other kernels are per-pixel loops. YCbCr is full
+// range, as in JPEG: Y from 0 to 255, and Cb, Cr centered on 128.
+
+// Planar output, one byte per sample in each of y, cb and cr
+void color_rgbToYcbcr(const uint8_t *rgb, uint8_t *y, uint8_t *cb, uint8_t *cr, int count,
+                      t_color_standard standard);
+void color_ycbcrToRgb(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgb, int count,
+                      t_color_standard standard);
+
+void color_rgbToLuma(const uint8_t *rgb, uint8_t *luma, int count, t_color_standard standard);
+
+// Replaces the luma of each pixel, keeping its chroma: the difference to
+// the exact luma is added to every channel. rgb and luma may not overlap.
+void color_setLuma(uint8_t *rgb, const uint8_t *luma, int count, t_color_standard standard);
+
+// Interleaved hue, saturation, value; the hue turns once over 0 to 255,
+// red at 0, green at 85 and blue at 171. rgb and hsv may be the same row.
+void color_rgbToHsv(const uint8_t *rgb, uint8_t *hsv, int count);
+void color_hsvToRgb(const uint8_t *hsv, uint8_t *rgb, int count);
+
+#endif // COLOR_H
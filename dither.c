@@ -0,0 +1,168 @@
+#include "dither.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+// Pixels of a Bayer row handled together, two threshold cycles
+#define DITHER_LANES 16
+
+typedef uint8_t t_dither_bytes __attribute__((vector_size(DITHER_LANES)));
+typedef uint16_t t_dither_words __attribute__((vector_size(DITHER_LANES * 2)));
+typedef uint32_t t_dither_ints __attribute__((vector_size(DITHER_LANES * 4)));
+
+// Recursive 8x8 Bayer matrix, thresholds 0 to 63
+static const uint8_t dither_bayer[8][8] = {
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21}
+};
+
+typedef struct {
+    uint8_t **rows;
+    int width;
+    int height;
+    int levels;
+    uint8_t nearest[256];   // Closest output level of every value
+    int16_t *errors[2];     // Error for the next row, in sixteenths; row y reads errors[y & 1]
+    int *progress;          // Pixels finished in each row
+    int nextRow;
+} t_dither_args;
+
+// Waits until row y has finished needed pixels
+static void dither_waitFor(t_dither_args *args, int y, int needed) {
+    while (__atomic_load_n(&args->progress[y], __ATOMIC_ACQUIRE) < needed) sched_yield();
+}
+
+static void dither_floydSteinbergRow(t_dither_args *args, int y) {
+    int width = args->width;
+    uint8_t *row = args->rows[y];
+    const int16_t *below = args->errors[y & 1];
+    int16_t *next = args->errors[(y + 1) & 1];
+    int carry = 0;
+
+    for (int x0 = 0; x0 < width; x0 += DITHER_BLOCK) {
+        int x1 = x0 + DITHER_BLOCK < width ? x0 + DITHER_BLOCK : width;
+        // The row above must have written below[x1 - 1], which it finishes
+        // at pixel x1, and read next[x1], which this block assigns
+        if (y > 0) dither_waitFor(args, y - 1, x1 + 1 < width ? x1 + 1 : width);
+        if (x0 == 0) next[0] = 0;
+
+        for (int x = x0; x < x1; x++) {
+            int value = row[x] + ((below[x] + carry + 8) >> 4);
+            value = value < 0 ? 0 : value > 255 ? 255 : value;
+            int error = value - args->nearest[value];
+            row[x] = args->nearest[value];
+
+            // 7/16 right, 3/16 below left, 5/16 below, 1/16 below right
+            carry = 7 * error;
+            if (x > 0) next[x - 1] += (int16_t)(3 * error);
+            next[x] += (int16_t)(5 * error);
+            if (x + 1 < width) next[x + 1] = (int16_t)error;
+        }
+
+        __atomic_store_n(&args->progress[y], x1, __ATOMIC_RELEASE);
+    }
+}
+
+// Claims rows in order until none are left
+static void dither_floydSteinbergTask(void *arg) {
+    t_dither_args *args = (t_dither_args *)arg;
+
+    for (;;) {
+        int y = __atomic_fetch_add(&args->nextRow, 1, __ATOMIC_RELAXED);
+        if (y >= args->height) break;
+        dither_floydSteinbergRow(args, y);
+    }
+}
+
+// Sums stay below 65536, so levels are found in 16-bit lanes; only the
+// product with the 16.16 step needs 32 bits
+static t_dither_bytes dither_bayerBlock(t_dither_bytes pixels, const t_dither_words *threshold, uint16_t scale,
+                                        uint32_t step) {
+    t_dither_words n = __builtin_convertvector(pixels, t_dither_words) * scale + *threshold;
+    t_dither_words level = (n + 1 + (n >> 8)) >> 8;   // n / 255
+    t_dither_ints value = (__builtin_convertvector(level, t_dither_ints) * step + 32768) >> 16;
+    return __builtin_convertvector(value, t_dither_bytes);
+}
+
+static void dither_bayerRows(void *ctx, int begin, int end) {
+    const t_dither_args *args = (const t_dither_args *)ctx;
+    uint32_t scale = (uint32_t)(args->levels - 1);
+    // Output value of a level, in 16.16 fixed point
+    uint32_t step = ((255u << 16) + scale / 2) / scale;
+
+    for (int y = begin; y < end; y++) {
+        uint8_t *row = args->rows[y];
+        // Thresholds spread over (0, 255), centered on each cell
+        t_dither_words threshold;
+        for (int k = 0; k < DITHER_LANES; k++) threshold[k] = ((2 * dither_bayer[y & 7][k & 7] + 1) * 255 + 64) / 128;
+
+        int x = 0;
+        t_dither_bytes pixels;
+        for (; x + DITHER_LANES <= args->width; x += DITHER_LANES) {
+            memcpy(&pixels, row + x, sizeof(pixels));
+            pixels = dither_bayerBlock(pixels, &threshold, (uint16_t)scale, step);
+            memcpy(row + x, &pixels, sizeof(pixels));
+        }
+        if (x < args->width) {
+            uint8_t tail[DITHER_LANES] = {0};
+            memcpy(tail, row + x, args->width - x);
+            memcpy(&pixels, tail, sizeof(pixels));
+            pixels = dither_bayerBlock(pixels, &threshold, (uint16_t)scale, step);
+            memcpy(row + x, &pixels, args->width - x);
+        }
+    }
+}
+
+int dither_apply(uint8_t **rows, int width, int height, int levels, t_dither_method method) {
+    if (!rows || width <= 0 || height <= 0 || levels < 2 || levels > 256) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    t_dither_args args;
+    args.rows = rows;
+    args.width = width;
+    args.height = height;
+    args.levels = levels;
+    args.nextRow = 0;
+
+    if (method == DITHER_BAYER) {
+        scheduler_parallelFor(0, height, scheduler_rowGrain(width), dither_bayerRows, &args);
+        return 1;
+    }
+
+    for (int v = 0; v < 256; v++) {
+        int level = (v * (levels - 1) + 127) / 255;
+        args.nearest[v] = (uint8_t)((level * 255 + (levels - 1) / 2) / (levels - 1));
+    }
+    args.errors[0] = (int16_t *)calloc(width, sizeof(int16_t));
+    args.errors[1] = (int16_t *)calloc(width, sizeof(int16_t));
+    args.progress = (int *)calloc(height, sizeof(int));
+    if (!args.errors[0] || !args.errors[1] || !args.progress) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(args.errors[0]);
+        free(args.errors[1]);
+        free(args.progress);
+        return 0;
+    }
+
+    // Rows are claimed only by tasks already running, so a row only ever
+    // waits for a row being processed, never for a task still queued
+    int workers = scheduler_threadCount() < height ? scheduler_threadCount() : height;
+    t_task_group group = {0};
+    for (int i = 0; i < workers; i++) scheduler_spawn(&group, dither_floydSteinbergTask, &args);
+    scheduler_wait(&group);
+
+    free(args.errors[0]);
+    free(args.errors[1]);
+    free(args.progress);
+    return 1;
+}
@@ -0,0 +1,28 @@
+#ifndef DITHER_H
+#define DITHER_H
+
+#include <stdint.h>
+
+// Pixels between progress updates of a Floyd-Steinberg row
+#define DITHER_BLOCK 128
+
+typedef enum {
+    DITHER_FLOYD_STEINBERG,   // Error diffusion, best for print
+    DITHER_BAYER              // 8x8 ordered dither, much faster
+} t_dither_method;
+
+// Reduces an 8-bit plane in place to levels gray values evenly spread
+// from 0 to 255, 2 giving black and white. Returns 0 on invalid
+// parameters or allocation failure.
+//
+// Floyd-Steinberg runs rows as a wavefront: each thread claims the next
+// row and follows the row above, so rows proceed together on a skew, one
+// DITHER_BLOCK of pixels apart. Errors are integers in sixteenths, kept in
+// two rolling rows shared by all the rows in flight; rows publish their
+// progress once per block, and waiting on it keeps that shared buffer free
+// of races.
+// The Bayer dither compares each pixel with a position-dependent
+// threshold, 16 pixels at a time in GCC vector types.
+int dither_apply(uint8_t **rows, int width, int height, int levels, t_dither_method method);
+
+#endif // DITHER_H
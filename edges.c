@@ -0,0 +1,343 @@
+#include "edges.h"
+#include "gaussian.h"
+#include "pool.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Marks left in dst by non-maximum suppression, then by hysteresis
+#define EDGES_NONE 0
+#define EDGES_WEAK 1
+#define EDGES_STRONG 2
+#define EDGES_EDGE 255
+
+// tan(22.5) and tan(67.5) in 1/256ths, bounding the direction sectors
+#define EDGES_TAN_22 106
+#define EDGES_TAN_67 618
+
+// Smallest band worth a task of its own
+#define EDGES_MIN_BAND 16
+
+// Gradient directions, named by the pair of neighbours compared against
+enum { EDGES_HORIZONTAL, EDGES_DIAGONAL, EDGES_VERTICAL, EDGES_ANTIDIAGONAL };
+
+typedef struct {
+    int *items;       // x, y pairs
+    size_t count;
+    size_t capacity;
+} t_edges_stack;
+
+typedef struct {
+    uint8_t **src;
+    uint8_t **dst;
+    int width;
+    int height;
+    int low;
+    int high;
+    int bandHeight;
+    int failed;
+} t_edges_args;
+
+static int edges_abs(int v) {
+    return v < 0 ? -v : v;
+}
+
+// Sobel gradients at x of the row b, a being the row above and c the one
+// below; xl and xr are the columns used as left and right neighbours
+static void edges_gradientAt(const uint8_t *a, const uint8_t *b, const uint8_t *c,
+                             int xl, int x, int xr, int *gx, int *gy) {
+    *gx = (a[xr] - a[xl]) + 2 * (b[xr] - b[xl]) + (c[xr] - c[xl]);
+    *gy = (c[xl] + 2 * c[x] + c[xr]) - (a[xl] + 2 * a[x] + a[xr]);
+}
+
+static void edges_sobelRows(void *ctx, int begin, int end) {
+    t_edges_args *args = (t_edges_args *)ctx;
+    int width = args->width;
+    int last = width - 1;
+
+    for (int y = begin; y < end; y++) {
+        const uint8_t *a = args->src[y > 0 ? y - 1 : 0];
+        const uint8_t *b = args->src[y];
+        const uint8_t *c = args->src[y < args->height - 1 ? y + 1 : y];
+        uint8_t *dst = args->dst[y];
+        int gx, gy;
+
+        // Border columns apart, so that the inner loop has no branches
+        for (int x = 1; x < last; x++) {
+            edges_gradientAt(a, b, c, x - 1, x, x + 1, &gx, &gy);
+            int magnitude = edges_abs(gx) + edges_abs(gy);
+            dst[x] = (uint8_t)(magnitude > 255 ? 255 : magnitude);
+        }
+        edges_gradientAt(a, b, c, 0, 0, width > 1 ? 1 : 0, &gx, &gy);
+        int first = edges_abs(gx) + edges_abs(gy);
+        if (width > 1) {
+            edges_gradientAt(a, b, c, last - 1, last, last, &gx, &gy);
+            int magnitude = edges_abs(gx) + edges_abs(gy);
+            dst[last] = (uint8_t)(magnitude > 255 ? 255 : magnitude);
+        }
+        dst[0] = (uint8_t)(first > 255 ? 255 : first);
+    }
+}
+
+void edges_sobel(uint8_t **src, uint8_t **dst, int width, int height) {
+    if (!src || !dst || width <= 0 || height <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    t_edges_args args = {src, dst, width, height, 0, 0, 0, 0};
+    scheduler_parallelFor(0, height, scheduler_rowGrain(width), edges_sobelRows, &args);
+}
+
+static void edges_gradientPixel(const uint8_t *a, const uint8_t *b, const uint8_t *c, int xl, int x, int xr,
+                                uint16_t *magnitude, uint8_t *direction) {
+    int gx, gy;
+    edges_gradientAt(a, b, c, xl, x, xr, &gx, &gy);
+    int ax = edges_abs(gx);
+    int ay = edges_abs(gy);
+
+    magnitude[x] = (uint16_t)(ax + ay);
+    if (ay * 256 <= ax * EDGES_TAN_22) {
+        direction[x] = EDGES_HORIZONTAL;
+    } else if (ay * 256 >= ax * EDGES_TAN_67) {
+        direction[x] = EDGES_VERTICAL;
+    } else {
+        direction[x] = (gx ^ gy) >= 0 ? EDGES_DIAGONAL : EDGES_ANTIDIAGONAL;
+    }
+}
+
+// Magnitudes and directions of row y; rows outside the image have none
+static void edges_gradientRow(const t_edges_args *args, int y, uint16_t *magnitude, uint8_t *direction) {
+    int width = args->width;
+    int last = width - 1;
+
+    if (y < 0 || y >= args->height) {
+        memset(magnitude, 0, width * sizeof(uint16_t));
+        return;
+    }
+
+    const uint8_t *a = args->src[y > 0 ? y - 1 : 0];
+    const uint8_t *b = args->src[y];
+    const uint8_t *c = args->src[y < args->height - 1 ? y + 1 : y];
+    for (int x = 1; x < last; x++) {
+        edges_gradientPixel(a, b, c, x - 1, x, x + 1, magnitude, direction);
+    }
+    edges_gradientPixel(a, b, c, 0, 0, width > 1 ? 1 : 0, magnitude, direction);
+    if (width > 1) edges_gradientPixel(a, b, c, last - 1, last, last, magnitude, direction);
+}
+
+// Keeps the pixels of row y that are maxima along their gradient direction,
+// marking them weak or strong. Magnitude rows have one zero column on
+// each side.
+static void edges_suppressRow(const t_edges_args *args, int y, const uint16_t *above, const uint16_t *row,
+                              const uint16_t *below, const uint8_t *direction) {
+    uint8_t *dst = args->dst[y];
+
+    for (int x = 0; x < args->width; x++) {
+        int magnitude = row[x];
+        uint8_t mark = EDGES_NONE;
+
+        if (magnitude >= args->low) {
+            int before, after;
+            switch (direction[x]) {
+                case EDGES_HORIZONTAL:
+                    before = row[x - 1];
+                    after = row[x + 1];
+                    break;
+                case EDGES_VERTICAL:
+                    before = above[x];
+                    after = below[x];
+                    break;
+                case EDGES_DIAGONAL:
+                    before = above[x - 1];
+                    after = below[x + 1];
+                    break;
+                default:
+                    before = above[x + 1];
+                    after = below[x - 1];
+                    break;
+            }
+            // Strict on one side only, so plateaus keep one pixel
+            if (magnitude > before && magnitude >= after) {
+                mark = magnitude >= args->high ? EDGES_STRONG : EDGES_WEAK;
+            }
+        }
+        dst[x] = mark;
+    }
+}
+
+static int edges_push(t_edges_stack *stack, int x, int y) {
+    if (stack->count + 2 > stack->capacity) {
+        size_t capacity = stack->capacity ? stack->capacity * 2 : 1024;
+        int *items = (int *)realloc(stack->items, capacity * sizeof(int));
+        if (!items) return 0;
+        stack->items = items;
+        stack->capacity = capacity;
+    }
+    stack->items[stack->count++] = x;
+    stack->items[stack->count++] = y;
+    return 1;
+}
+
+// Marks as edges the weak and strong pixels 8-connected to the stacked
+// ones, without leaving rows [top, bottom)
+static int edges_flood(uint8_t **dst, int width, int top, int bottom, t_edges_stack *stack) {
+    while (stack->count) {
+        int y = stack->items[--stack->count];
+        int x = stack->items[--stack->count];
+
+        for (int ny = y - 1; ny <= y + 1; ny++) {
+            if (ny < top || ny >= bottom) continue;
+            uint8_t *row = dst[ny];
+            for (int nx = x - 1; nx <= x + 1; nx++) {
+                if (nx < 0 || nx >= width) continue;
+                if (row[nx] == EDGES_WEAK || row[nx] == EDGES_STRONG) {
+                    row[nx] = EDGES_EDGE;
+                    if (!edges_push(stack, nx, ny)) return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+// Gradients stream through a ring of three rows: once row y + 1 is in,
+// row y is suppressed. Hysteresis then runs inside the band.
+static void edges_cannyBands(void *ctx, int begin, int end) {
+    t_edges_args *args = (t_edges_args *)ctx;
+    int width = args->width;
+    size_t padded = (size_t)width + 2;
+    uint16_t *magnitudes = (uint16_t *)calloc(3 * padded, sizeof(uint16_t));
+    uint8_t *directions = (uint8_t *)malloc(3 * (size_t)width);
+    t_edges_stack stack = {NULL, 0, 0};
+    if (!magnitudes || !directions) {
+        __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+        free(magnitudes);
+        free(directions);
+        return;
+    }
+
+    for (int band = begin; band < end; band++) {
+        int y0 = band * args->bandHeight;
+        int y1 = y0 + args->bandHeight < args->height ? y0 + args->bandHeight : args->height;
+
+        // Row y lives in slot (y - y0 + 1) % 3
+        for (int y = y0 - 1; y <= y1; y++) {
+            int slot = (y - y0 + 1) % 3;
+            edges_gradientRow(args, y, magnitudes + slot * padded + 1, directions + slot * (size_t)width);
+            if (y <= y0) continue;
+
+            int center = (y - y0) % 3;
+            edges_suppressRow(args, y - 1,
+                              magnitudes + ((y - y0 + 2) % 3) * padded + 1,
+                              magnitudes + center * padded + 1,
+                              magnitudes + slot * padded + 1,
+                              directions + center * (size_t)width);
+        }
+
+        for (int y = y0; y < y1; y++) {
+            uint8_t *row = args->dst[y];
+            for (int x = 0; x < width; x++) {
+                if (row[x] != EDGES_STRONG) continue;
+                row[x] = EDGES_EDGE;
+                if (!edges_push(&stack, x, y) || !edges_flood(args->dst, width, y0, y1, &stack)) {
+                    __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+                    y = y1;
+                    break;
+                }
+            }
+        }
+    }
+
+    free(magnitudes);
+    free(directions);
+    free(stack.items);
+}
+
+// Components crossing a band boundary were only followed inside each
+// band: weak pixels touching an edge across a boundary restart the fill
+static int edges_joinBands(const t_edges_args *args, int bands) {
+    t_edges_stack stack = {NULL, 0, 0};
+    int ok = 1;
+
+    for (int band = 1; band < bands && ok; band++) {
+        int y = band * args->bandHeight;
+        for (int side = 0; side < 2 && ok; side++) {
+            const uint8_t *from = args->dst[side ? y : y - 1];
+            int to = side ? y - 1 : y;
+            uint8_t *row = args->dst[to];
+            for (int x = 0; x < args->width && ok; x++) {
+                if (from[x] != EDGES_EDGE) continue;
+                for (int nx = x - 1; nx <= x + 1; nx++) {
+                    if (nx < 0 || nx >= args->width || row[nx] != EDGES_WEAK) continue;
+                    row[nx] = EDGES_EDGE;
+                    if (!edges_push(&stack, nx, to)) ok = 0;
+                }
+            }
+        }
+    }
+
+    if (ok) ok = edges_flood(args->dst, args->width, 0, args->height, &stack);
+    free(stack.items);
+    return ok;
+}
+
+static void edges_finishRows(void *ctx, int begin, int end) {
+    t_edges_args *args = (t_edges_args *)ctx;
+    for (int y = begin; y < end; y++) {
+        uint8_t *row = args->dst[y];
+        for (int x = 0; x < args->width; x++) row[x] = row[x] == EDGES_EDGE ? 255 : 0;
+    }
+}
+
+int edges_canny(uint8_t **src, uint8_t **dst, int width, int height, float sigma, int low, int high) {
+    if (!src || !dst || width <= 0 || height <= 0 || sigma < 0 || low < 0 || high < low) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    t_edges_args args = {src, dst, width, height, low, high, 0, 0};
+    uint8_t *plane = NULL;
+    uint8_t **blurred = NULL;
+
+    if (sigma > 0) {
+        size_t stride = POOL_ROW_STRIDE(width);
+        plane = (uint8_t *)pool_acquire(stride * height);
+        blurred = (uint8_t **)malloc(height * sizeof(uint8_t *));
+        if (!plane || !blurred) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            pool_release(plane);
+            free(blurred);
+            return 0;
+        }
+        for (int y = 0; y < height; y++) {
+            blurred[y] = plane + (size_t)y * stride;
+            memcpy(blurred[y], src[y], width);
+        }
+        if (!gaussian_iir(blurred, width, height, 1, sigma)) {
+            pool_release(plane);
+            free(blurred);
+            return 0;
+        }
+        args.src = blurred;
+    }
+
+    int bands = scheduler_threadCount() * 4;
+    int bandHeight = (height + bands - 1) / bands;
+    if (bandHeight < EDGES_MIN_BAND) bandHeight = EDGES_MIN_BAND;
+    args.bandHeight = bandHeight;
+    bands = (height + bandHeight - 1) / bandHeight;
+
+    scheduler_parallelFor(0, bands, 1, edges_cannyBands, &args);
+    if (!args.failed && !edges_joinBands(&args, bands)) args.failed = 1;
+    if (!args.failed) {
+        scheduler_parallelFor(0, height, scheduler_rowGrain(width), edges_finishRows, &args);
+    } else {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+    }
+
+    pool_release(plane);
+    free(blurred);
+    return !args.failed;
+}
@@ -0,0 +1,27 @@
+#ifndef EDGES_H
+#define EDGES_H
+
+#include <stdint.h>
+
+// Gradient magnitudes are |gx| + |gy| of the 3x3 Sobel kernels, 0 to 2040;
+// Canny thresholds are in the same units
+#define EDGES_MAX_MAGNITUDE 2040
+#define EDGES_DEFAULT_SIGMA 1.4f
+#define EDGES_DEFAULT_LOW 60
+#define EDGES_DEFAULT_HIGH 150
+
+// Sobel gradient magnitude of one 8-bit plane, clamped to 255. Both
+// gradients come from the same pass over the three source rows.
+// src and dst must not overlap; edges are extended with the border pixels.
+void edges_sobel(uint8_t **src, uint8_t **dst, int width, int height);
+
+// Canny edge map of one 8-bit plane: 255 on edges, 0 elsewhere. The plane
+// is blurred with a Gaussian of the given sigma (0 skips it), gradients
+// are thinned to their local maxima along the quantized gradient direction,
+// and pixels above low are kept when connected to a pixel above high.
+// Bands of rows run in parallel; components crossing bands are joined
+// afterwards. src is left untouched and must not overlap dst.
+// Returns 0 on allocation failure.
+int edges_canny(uint8_t **src, uint8_t **dst, int width, int height, float sigma, int low, int high);
+
+#endif // EDGES_H
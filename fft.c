@@ -0,0 +1,348 @@
+#include "fft.h"
+#include "pool.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Largest transform size tried for a tile
+#define FFT_MAX_SIZE 4096
+
+typedef struct {
+    float re;
+    float im;
+} t_complex;
+
+// Twiddle factors and bit-reversal table of one transform size
+typedef struct {
+    int n;
+    t_complex *twiddles;  // exp(-2 pi i k / n) for k < n / 2
+    int *reversed;
+} t_fft_plan;
+
+typedef struct {
+    uint8_t **rows;
+    int width;
+    int height;
+    int channels;
+    int kernelSize;
+    int tile;                  // Input pixels per tile side
+    const t_fft_plan *plan;
+    const t_complex *spectrum; // Transformed, flipped and scaled kernel
+    float *sum;                // Overlap-add accumulator, interleaved like rows
+    size_t sumStride;
+    int phaseX;
+    int phaseY;
+    int phaseColumns;
+    int failed;
+} t_fft_args;
+
+static int fft_crossoverSize = FFT_DEFAULT_CROSSOVER;
+
+int fft_crossover(void) {
+    return fft_crossoverSize;
+}
+
+void fft_setCrossover(int kernelSize) {
+    fft_crossoverSize = kernelSize;
+}
+
+static int fft_planInit(t_fft_plan *plan, int n) {
+    plan->n = n;
+    plan->twiddles = (t_complex *)malloc((n / 2) * sizeof(t_complex));
+    plan->reversed = (int *)malloc(n * sizeof(int));
+    if (!plan->twiddles || !plan->reversed) {
+        free(plan->twiddles);
+        free(plan->reversed);
+        return 0;
+    }
+
+    for (int k = 0; k < n / 2; k++) {
+        double angle = -2.0 * M_PI * k / n;
+        plan->twiddles[k].re = (float)cos(angle);
+        plan->twiddles[k].im = (float)sin(angle);
+    }
+
+    int bits = 0;
+    while ((1 << bits) < n) bits++;
+    for (int i = 0; i < n; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        plan->reversed[i] = r;
+    }
+    return 1;
+}
+
+static void fft_planFree(t_fft_plan *plan) {
+    free(plan->twiddles);
+    free(plan->reversed);
+}
+
+// In-place radix-2 transform of one row of n samples. The inverse is not
+// scaled; the 1 / n^2 of the 2D inverse is folded into the kernel spectrum.
+static void fft_transform(const t_fft_plan *plan, t_complex *data, int inverse) {
+    int n = plan->n;
+    float sign = inverse ? -1.0f : 1.0f;
+
+    for (int i = 0; i < n; i++) {
+        int j = plan->reversed[i];
+        if (i < j) {
+            t_complex t = data[i];
+            data[i] = data[j];
+            data[j] = t;
+        }
+    }
+
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len / 2;
+        int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < half; j++) {
+                t_complex w = plan->twiddles[j * step];
+                t_complex *a = &data[i + j];
+                t_complex *b = &data[i + j + half];
+                float vr = b->re * w.re - b->im * w.im * sign;
+                float vi = b->re * w.im * sign + b->im * w.re;
+                b->re = a->re - vr;
+                b->im = a->im - vi;
+                a->re += vr;
+                a->im += vi;
+            }
+        }
+    }
+}
+
+// Transforms every column of an n x n block at once: the butterflies combine
+// whole rows, so the inner loop runs over contiguous memory
+static void fft_transformColumns(const t_fft_plan *plan, t_complex *data, int inverse) {
+    int n = plan->n;
+    float sign = inverse ? -1.0f : 1.0f;
+
+    for (int i = 0; i < n; i++) {
+        int j = plan->reversed[i];
+        if (i < j) {
+            t_complex *a = data + (size_t)i * n;
+            t_complex *b = data + (size_t)j * n;
+            for (int x = 0; x < n; x++) {
+                t_complex t = a[x];
+                a[x] = b[x];
+                b[x] = t;
+            }
+        }
+    }
+
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len / 2;
+        int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < half; j++) {
+                float wr = plan->twiddles[j * step].re;
+                float wi = plan->twiddles[j * step].im * sign;
+                t_complex *a = data + (size_t)(i + j) * n;
+                t_complex *b = data + (size_t)(i + j + half) * n;
+                for (int x = 0; x < n; x++) {
+                    float vr = b[x].re * wr - b[x].im * wi;
+                    float vi = b[x].re * wi + b[x].im * wr;
+                    b[x].re = a[x].re - vr;
+                    b[x].im = a[x].im - vi;
+                    a[x].re += vr;
+                    a[x].im += vi;
+                }
+            }
+        }
+    }
+}
+
+// Convolves two horizontally adjacent tiles of one channel: the left tile
+// is loaded as the real part and the right one as the imaginary part, which
+// the real kernel keeps apart, so one complex transform serves both
+static void fft_tilePair(t_fft_args *args, t_complex *buffer, int x0, int y0, int channel) {
+    int n = args->plan->n;
+    int tile = args->tile;
+    int half = args->kernelSize / 2;
+    int ch = args->channels;
+    int x1 = x0 + tile;
+    int rowsUsed = args->height - y0 < tile ? args->height - y0 : tile;
+
+    memset(buffer, 0, (size_t)n * n * sizeof(t_complex));
+    for (int p = 0; p < rowsUsed; p++) {
+        const uint8_t *src = args->rows[y0 + p];
+        t_complex *line = buffer + (size_t)p * n;
+        for (int q = 0; q < tile && x0 + q < args->width; q++) {
+            line[q].re = src[(x0 + q) * ch + channel];
+        }
+        for (int q = 0; q < tile && x1 + q < args->width; q++) {
+            line[q].im = src[(x1 + q) * ch + channel];
+        }
+        fft_transform(args->plan, line, 0);
+    }
+    fft_transformColumns(args->plan, buffer, 0);
+
+    for (size_t i = 0; i < (size_t)n * n; i++) {
+        t_complex a = buffer[i];
+        t_complex k = args->spectrum[i];
+        buffer[i].re = a.re * k.re - a.im * k.im;
+        buffer[i].im = a.re * k.im + a.im * k.re;
+    }
+
+    fft_transformColumns(args->plan, buffer, 1);
+
+    // Full linear convolution of a tile spans tile + kernelSize - 1 samples
+    int span = tile + args->kernelSize - 1;
+    for (int p = 0; p < span; p++) {
+        int y = y0 + p - half;
+        if (y < 0 || y >= args->height) continue;
+
+        t_complex *line = buffer + (size_t)p * n;
+        fft_transform(args->plan, line, 1);
+
+        float *sum = args->sum + (size_t)y * args->sumStride;
+        for (int q = 0; q < span; q++) {
+            int x = x0 + q - half;
+            if (x >= 0 && x < args->width) sum[x * ch + channel] += line[q].re;
+            x = x1 + q - half;
+            if (x >= 0 && x < args->width) sum[x * ch + channel] += line[q].im;
+        }
+    }
+}
+
+// Blocks of two tiles in the current phase. Blocks of one phase are two
+// blocks apart in both directions, so their overlaps never touch.
+static void fft_blocks(void *ctx, int begin, int end) {
+    t_fft_args *args = (t_fft_args *)ctx;
+    int n = args->plan->n;
+    t_complex *buffer = (t_complex *)pool_acquire((size_t)n * n * sizeof(t_complex));
+    if (!buffer) {
+        __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    for (int i = begin; i < end; i++) {
+        int bx = args->phaseX + 2 * (i % args->phaseColumns);
+        int by = args->phaseY + 2 * (i / args->phaseColumns);
+        for (int c = 0; c < args->channels; c++) {
+            fft_tilePair(args, buffer, bx * 2 * args->tile, by * args->tile, c);
+        }
+    }
+
+    pool_release(buffer);
+}
+
+static void fft_storeRows(void *ctx, int begin, int end) {
+    t_fft_args *args = (t_fft_args *)ctx;
+    int half = args->kernelSize / 2;
+    int ch = args->channels;
+
+    for (int y = begin; y < end; y++) {
+        const float *sum = args->sum + (size_t)y * args->sumStride;
+        uint8_t *dst = args->rows[y];
+        for (int i = half * ch; i < (args->width - half) * ch; i++) {
+            float v = sum[i];
+            dst[i] = (uint8_t)(v > 255 ? 255 : (v < 0 ? 0 : v));
+        }
+    }
+}
+
+// Picks the transform size with the least work for the whole image
+static int fft_chooseSize(int width, int height, int kernelSize) {
+    int best = 0;
+    double bestCost = 0;
+
+    for (int n = 16; n <= FFT_MAX_SIZE; n *= 2) {
+        int tile = n - kernelSize + 1;
+        if (tile < kernelSize) continue;
+
+        double blocks = (double)((width + 2 * tile - 1) / (2 * tile)) * ((height + tile - 1) / tile);
+        double cost = blocks * n * n * log2(n);
+        if (!best || cost < bestCost) {
+            best = n;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+int fft_correlate(uint8_t **rows, int width, int height, int channels, float **kernel, int kernelSize) {
+    if (!rows || !kernel || width <= 0 || height <= 0 || channels <= 0 || kernelSize % 2 == 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+    // No pixel is far enough from the border to be filtered
+    if (width < kernelSize || height < kernelSize) return 1;
+
+    int n = fft_chooseSize(width, height, kernelSize);
+    if (!n) {
+        fprintf(stderr, "Error: Kernel too large\n");
+        return 0;
+    }
+
+    t_fft_plan plan;
+    if (!fft_planInit(&plan, n)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 0;
+    }
+
+    t_fft_args args;
+    args.rows = rows;
+    args.width = width;
+    args.height = height;
+    args.channels = channels;
+    args.kernelSize = kernelSize;
+    args.tile = n - kernelSize + 1;
+    args.plan = &plan;
+    args.sumStride = POOL_ROW_STRIDE((size_t)width * channels);
+    args.failed = 0;
+
+    t_complex *spectrum = (t_complex *)pool_acquire((size_t)n * n * sizeof(t_complex));
+    args.sum = (float *)pool_acquire(args.sumStride * height * sizeof(float));
+    if (!spectrum || !args.sum) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        pool_release(spectrum);
+        pool_release(args.sum);
+        fft_planFree(&plan);
+        return 0;
+    }
+
+    // Correlation is convolution with the flipped kernel
+    float scale = 1.0f / ((float)n * n);
+    memset(spectrum, 0, (size_t)n * n * sizeof(t_complex));
+    for (int a = 0; a < kernelSize; a++) {
+        t_complex *line = spectrum + (size_t)a * n;
+        for (int b = 0; b < kernelSize; b++) {
+            line[b].re = kernel[kernelSize - 1 - a][kernelSize - 1 - b] * scale;
+        }
+        fft_transform(&plan, line, 0);
+    }
+    fft_transformColumns(&plan, spectrum, 0);
+    args.spectrum = spectrum;
+
+    memset(args.sum, 0, args.sumStride * height * sizeof(float));
+
+    int tilesX = (width + args.tile - 1) / args.tile;
+    int tilesY = (height + args.tile - 1) / args.tile;
+    int blocksX = (tilesX + 1) / 2;
+    for (int phase = 0; phase < 4; phase++) {
+        args.phaseX = phase & 1;
+        args.phaseY = phase >> 1;
+        args.phaseColumns = (blocksX - args.phaseX + 1) / 2;
+        int phaseRows = (tilesY - args.phaseY + 1) / 2;
+        if (args.phaseColumns <= 0 || phaseRows <= 0) continue;
+        scheduler_parallelFor(0, args.phaseColumns * phaseRows, 1, fft_blocks, &args);
+    }
+
+    // The image is only written once every tile succeeded
+    if (!args.failed) {
+        int half = kernelSize / 2;
+        scheduler_parallelFor(half, height - half, scheduler_rowGrain(width * channels), fft_storeRows, &args);
+    } else {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+    }
+
+    pool_release(spectrum);
+    pool_release(args.sum);
+    fft_planFree(&plan);
+    return !args.failed;
+}
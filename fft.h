@@ -0,0 +1,24 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <stdint.h>
+
+// Kernel size from which bmp8_applyFilter and bmp24_applyFilter switch from
+// direct summation to FFT convolution. Measured with the benchmark program,
+// which prints the crossover for the machine it runs on.
+#define FFT_DEFAULT_CROSSOVER 5
+
+int fft_crossover(void);
+void fft_setCrossover(int kernelSize);
+
+// Applies a kernelSize x kernelSize kernel the same way the direct filters
+// do: out(x, y) = sum kernel[j][i] * in(x + i - half, y + j - half), for
+// every pixel at least half a kernel away from the border; border pixels are
+// left unchanged. rows[y] points to width pixels of channels interleaved
+// 8-bit samples, every channel is filtered independently. The image is cut
+// into tiles that are transformed with a radix-2 FFT, multiplied by the
+// kernel spectrum and added back with their overlap.
+// Returns 0 on allocation failure.
+int fft_correlate(uint8_t **rows, int width, int height, int channels, float **kernel, int kernelSize);
+
+#endif // FFT_H
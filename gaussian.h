@@ -0,0 +1,18 @@
+#ifndef GAUSSIAN_H
+#define GAUSSIAN_H
+
+#include <stdint.h>
+
+// Smallest sigma handled by the recursive filter: its coefficient fit
+// breaks down below 0.5 and loses accuracy well before
+#define GAUSSIAN_IIR_MIN_SIGMA 1.0f
+
+// Gaussian blur of any sigma at constant cost per pixel, using the
+// recursive Young-van Vliet filter run forward and backward along rows,
+// then along columns. Sigmas below GAUSSIAN_IIR_MIN_SIGMA use a sampled
+// kernel of radius ceil(3 * sigma) instead. rows[y] points to width pixels
+// of channels interleaved 8-bit samples; every channel is blurred
+// independently. Returns 0 on invalid parameters or allocation failure.
+int gaussian_iir(uint8_t **rows, int width, int height, int channels, float sigma);
+
+#endif // GAUSSIAN_H
@@ -0,0 +1,272 @@
+#include "guided.h"
+#include "pool.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Smallest band worth a task of its own
+#define GUIDED_MIN_BAND 16
+
+typedef struct {
+    uint8_t **guide;
+    uint8_t **rows;
+    int width;
+    int height;
+    int channels;
+    int radius;
+    double epsilon;       // In squared gray levels
+    float *a;             // Coefficient planes, stride floats per row
+    float *b;
+    size_t stride;
+    int bandHeight;
+    int failed;
+} t_guided_args;
+
+// Window sums of every column over the rows of the current window
+typedef struct {
+    uint32_t *guide;
+    uint32_t *input;
+    uint64_t *product;
+    uint64_t *square;
+} t_guided_columns;
+
+static int guided_min(int a, int b) {
+    return a < b ? a : b;
+}
+
+static int guided_max(int a, int b) {
+    return a > b ? a : b;
+}
+
+// Rows of the window around y, clipped to the image
+static int guided_rowCount(const t_guided_args *args, int y) {
+    return guided_min(y + args->radius, args->height - 1) - guided_max(y - args->radius, 0) + 1;
+}
+
+static void guided_addStatistics(const t_guided_args *args, t_guided_columns *columns, int y, int sign) {
+    const uint8_t *guide = args->guide[y];
+    const uint8_t *input = args->rows[y];
+    int samples = args->width * args->channels;
+
+    if (sign > 0) {
+        for (int i = 0; i < samples; i++) {
+            columns->guide[i] += guide[i];
+            columns->input[i] += input[i];
+            columns->product[i] += (uint32_t)guide[i] * input[i];
+            columns->square[i] += (uint32_t)guide[i] * guide[i];
+        }
+    } else {
+        for (int i = 0; i < samples; i++) {
+            columns->guide[i] -= guide[i];
+            columns->input[i] -= input[i];
+            columns->product[i] -= (uint32_t)guide[i] * input[i];
+            columns->square[i] -= (uint32_t)guide[i] * guide[i];
+        }
+    }
+}
+
+// Fits a and b of row y from the column sums, sliding the window along x
+static void guided_fitRow(const t_guided_args *args, const t_guided_columns *columns, int y) {
+    int ch = args->channels;
+    int r = args->radius;
+    int width = args->width;
+    int rowCount = guided_rowCount(args, y);
+    float *a = args->a + (size_t)y * args->stride;
+    float *b = args->b + (size_t)y * args->stride;
+
+    for (int c = 0; c < ch; c++) {
+        uint64_t guide = 0, input = 0, product = 0, square = 0;
+        for (int x = 0; x <= guided_min(r, width - 1); x++) {
+            guide += columns->guide[x * ch + c];
+            input += columns->input[x * ch + c];
+            product += columns->product[x * ch + c];
+            square += columns->square[x * ch + c];
+        }
+
+        for (int x = 0; x < width; x++) {
+            double count = (double)(guided_min(x + r, width - 1) - guided_max(x - r, 0) + 1) * rowCount;
+            double meanGuide = guide / count;
+            double meanInput = input / count;
+            double variance = square / count - meanGuide * meanGuide;
+            double covariance = product / count - meanGuide * meanInput;
+            double slope = covariance / (variance + args->epsilon);
+            a[x * ch + c] = (float)slope;
+            b[x * ch + c] = (float)(meanInput - slope * meanGuide);
+
+            int enter = x + r + 1;
+            int leave = x - r;
+            if (enter < width) {
+                guide += columns->guide[enter * ch + c];
+                input += columns->input[enter * ch + c];
+                product += columns->product[enter * ch + c];
+                square += columns->square[enter * ch + c];
+            }
+            if (leave >= 0) {
+                guide -= columns->guide[leave * ch + c];
+                input -= columns->input[leave * ch + c];
+                product -= columns->product[leave * ch + c];
+                square -= columns->square[leave * ch + c];
+            }
+        }
+    }
+}
+
+static void guided_bandRange(const t_guided_args *args, int band, int *y0, int *y1) {
+    *y0 = band * args->bandHeight;
+    *y1 = guided_min(*y0 + args->bandHeight, args->height);
+}
+
+// First pass: the four statistics in one sweep, giving a and b
+static void guided_fit(void *ctx, int begin, int end) {
+    t_guided_args *args = (t_guided_args *)ctx;
+    int samples = args->width * args->channels;
+    int r = args->radius;
+    t_guided_columns columns;
+    columns.guide = (uint32_t *)malloc(samples * sizeof(uint32_t));
+    columns.input = (uint32_t *)malloc(samples * sizeof(uint32_t));
+    columns.product = (uint64_t *)malloc(samples * sizeof(uint64_t));
+    columns.square = (uint64_t *)malloc(samples * sizeof(uint64_t));
+    if (!columns.guide || !columns.input || !columns.product || !columns.square) {
+        __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+    } else {
+        for (int band = begin; band < end; band++) {
+            int y0, y1;
+            guided_bandRange(args, band, &y0, &y1);
+            memset(columns.guide, 0, samples * sizeof(uint32_t));
+            memset(columns.input, 0, samples * sizeof(uint32_t));
+            memset(columns.product, 0, samples * sizeof(uint64_t));
+            memset(columns.square, 0, samples * sizeof(uint64_t));
+            for (int y = guided_max(y0 - r, 0); y <= guided_min(y0 + r, args->height - 1); y++) {
+                guided_addStatistics(args, &columns, y, 1);
+            }
+
+            for (int y = y0; y < y1; y++) {
+                guided_fitRow(args, &columns, y);
+                if (y + r + 1 < args->height) guided_addStatistics(args, &columns, y + r + 1, 1);
+                if (y - r >= 0) guided_addStatistics(args, &columns, y - r, -1);
+            }
+        }
+    }
+
+    free(columns.guide);
+    free(columns.input);
+    free(columns.product);
+    free(columns.square);
+}
+
+static void guided_addCoefficients(const t_guided_args *args, double *sumA, double *sumB, int y, double sign) {
+    const float *a = args->a + (size_t)y * args->stride;
+    const float *b = args->b + (size_t)y * args->stride;
+    int samples = args->width * args->channels;
+    for (int i = 0; i < samples; i++) {
+        sumA[i] += sign * a[i];
+        sumB[i] += sign * b[i];
+    }
+}
+
+// Second pass: box means of a and b, applied to the guide
+static void guided_apply(void *ctx, int begin, int end) {
+    t_guided_args *args = (t_guided_args *)ctx;
+    int ch = args->channels;
+    int r = args->radius;
+    int width = args->width;
+    int samples = width * ch;
+    double *sumA = (double *)malloc(samples * sizeof(double));
+    double *sumB = (double *)malloc(samples * sizeof(double));
+    if (!sumA || !sumB) {
+        __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+        free(sumA);
+        free(sumB);
+        return;
+    }
+
+    for (int band = begin; band < end; band++) {
+        int y0, y1;
+        guided_bandRange(args, band, &y0, &y1);
+        memset(sumA, 0, samples * sizeof(double));
+        memset(sumB, 0, samples * sizeof(double));
+        for (int y = guided_max(y0 - r, 0); y <= guided_min(y0 + r, args->height - 1); y++) {
+            guided_addCoefficients(args, sumA, sumB, y, 1);
+        }
+
+        for (int y = y0; y < y1; y++) {
+            const uint8_t *guide = args->guide[y];
+            uint8_t *row = args->rows[y];
+            int rowCount = guided_rowCount(args, y);
+
+            for (int c = 0; c < ch; c++) {
+                double a = 0, b = 0;
+                for (int x = 0; x <= guided_min(r, width - 1); x++) {
+                    a += sumA[x * ch + c];
+                    b += sumB[x * ch + c];
+                }
+
+                for (int x = 0; x < width; x++) {
+                    double count = (double)(guided_min(x + r, width - 1) - guided_max(x - r, 0) + 1) * rowCount;
+                    double value = (a * guide[x * ch + c] + b) / count + 0.5;
+                    row[x * ch + c] = (uint8_t)(value > 255 ? 255 : (value < 0 ? 0 : value));
+
+                    if (x + r + 1 < width) {
+                        a += sumA[(x + r + 1) * ch + c];
+                        b += sumB[(x + r + 1) * ch + c];
+                    }
+                    if (x - r >= 0) {
+                        a -= sumA[(x - r) * ch + c];
+                        b -= sumB[(x - r) * ch + c];
+                    }
+                }
+            }
+
+            if (y + r + 1 < args->height) guided_addCoefficients(args, sumA, sumB, y + r + 1, 1);
+            if (y - r >= 0) guided_addCoefficients(args, sumA, sumB, y - r, -1);
+        }
+    }
+
+    free(sumA);
+    free(sumB);
+}
+
+int guided_filter(uint8_t **guide, uint8_t **rows, int width, int height, int channels, int radius,
+                  float epsilon) {
+    if (!guide || !rows || width <= 0 || height <= 0 || channels <= 0 || radius < 1 || epsilon <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    t_guided_args args;
+    args.guide = guide;
+    args.rows = rows;
+    args.width = width;
+    args.height = height;
+    args.channels = channels;
+    args.radius = radius;
+    args.epsilon = (double)epsilon * 255 * 255;
+    args.stride = POOL_ROW_STRIDE((size_t)width * channels);
+    args.failed = 0;
+    args.a = (float *)pool_acquire(args.stride * height * sizeof(float));
+    args.b = (float *)pool_acquire(args.stride * height * sizeof(float));
+    if (!args.a || !args.b) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        pool_release(args.a);
+        pool_release(args.b);
+        return 0;
+    }
+
+    // Every band sums its first window from scratch, so bands are kept
+    // tall compared with the window
+    int bands = scheduler_threadCount() * 4;
+    int bandHeight = (height + bands - 1) / bands;
+    bandHeight = guided_max(bandHeight, guided_max(GUIDED_MIN_BAND, 2 * radius));
+    args.bandHeight = bandHeight;
+    bands = (height + bandHeight - 1) / bandHeight;
+
+    // The output rows may be the guide, so all of a and b is fitted first
+    scheduler_parallelFor(0, bands, 1, guided_fit, &args);
+    if (!args.failed) scheduler_parallelFor(0, bands, 1, guided_apply, &args);
+    if (args.failed) fprintf(stderr, "Error: Memory allocation failed\n");
+
+    pool_release(args.a);
+    pool_release(args.b);
+    return !args.failed;
+}
@@ -0,0 +1,21 @@
+#ifndef GUIDED_H
+#define GUIDED_H
+
+#include <stdint.h>
+
+// Regularization for intensities scaled to 0..1; larger values smooth
+// stronger edges away
+#define GUIDED_DEFAULT_EPSILON 0.01f
+
+// Guided filter (He, Sun & Tang, 2010) of channels interleaved 8-bit
+// samples: every output is a * guide + b, a and b being fitted over each
+// (2 * radius + 1)^2 window and then averaged over the windows covering
+// the pixel. guide has the same layout as rows and may be rows itself,
+// which gives edge-preserving smoothing. Box means come from running
+// sums, so the cost does not depend on radius; a and b are kept in float
+// planes. Windows are clipped at the image borders.
+// Returns 0 on allocation failure.
+int guided_filter(uint8_t **guide, uint8_t **rows, int width, int height, int channels, int radius,
+                  float epsilon);
+
+#endif // GUIDED_H
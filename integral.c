@@ -0,0 +1,159 @@
+#include "integral.h"
+#include "pool.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Table entries accumulated down the rows together by one task
+#define INTEGRAL_COLUMN_BLOCK 1024
+
+typedef struct {
+    uint8_t **rows;
+    t_integral *table;
+} t_integral_args;
+
+// Whether the sum of width x height samples of at most max needs 64 bits
+static int integral_needsWide(int width, int height, uint64_t max) {
+    return (uint64_t)width * height * max > UINT32_MAX;
+}
+
+static void *integral_allocate(const t_integral *table, int wide) {
+    size_t bytes = table->stride * (table->height + 1) * (wide ? sizeof(uint64_t) : sizeof(uint32_t));
+    void *data = pool_acquire(bytes);
+    // The first row stays zero
+    if (data) memset(data, 0, table->stride * (wide ? sizeof(uint64_t) : sizeof(uint32_t)));
+    return data;
+}
+
+// First pass: running sums along each row, written to the table row below
+static void integral_rowSums(void *ctx, int begin, int end) {
+    t_integral_args *args = (t_integral_args *)ctx;
+    t_integral *table = args->table;
+    int ch = table->channels;
+    int samples = table->width * ch;
+
+    for (int y = begin; y < end; y++) {
+        const uint8_t *src = args->rows[y];
+        size_t offset = (size_t)(y + 1) * table->stride;
+
+        if (table->sumWide) {
+            uint64_t *dst = (uint64_t *)table->sum + offset;
+            for (int c = 0; c < ch; c++) dst[c] = 0;
+            for (int i = 0; i < samples; i++) dst[i + ch] = dst[i] + src[i];
+        } else {
+            uint32_t *dst = (uint32_t *)table->sum + offset;
+            for (int c = 0; c < ch; c++) dst[c] = 0;
+            for (int i = 0; i < samples; i++) dst[i + ch] = dst[i] + src[i];
+        }
+
+        if (!table->squares) continue;
+        if (table->squaresWide) {
+            uint64_t *dst = (uint64_t *)table->squares + offset;
+            for (int c = 0; c < ch; c++) dst[c] = 0;
+            for (int i = 0; i < samples; i++) dst[i + ch] = dst[i] + (uint32_t)src[i] * src[i];
+        } else {
+            uint32_t *dst = (uint32_t *)table->squares + offset;
+            for (int c = 0; c < ch; c++) dst[c] = 0;
+            for (int i = 0; i < samples; i++) dst[i + ch] = dst[i] + (uint32_t)src[i] * src[i];
+        }
+    }
+}
+
+// Adds each table row to the one below, for the entries [begin, end) of
+// every row; the inner loop runs over contiguous entries
+static void integral_accumulate(void *table, int wide, size_t stride, int height, size_t begin, size_t end) {
+    for (int y = 2; y <= height; y++) {
+        if (wide) {
+            uint64_t *dst = (uint64_t *)table + (size_t)y * stride;
+            const uint64_t *above = dst - stride;
+            for (size_t i = begin; i < end; i++) dst[i] += above[i];
+        } else {
+            uint32_t *dst = (uint32_t *)table + (size_t)y * stride;
+            const uint32_t *above = dst - stride;
+            for (size_t i = begin; i < end; i++) dst[i] += above[i];
+        }
+    }
+}
+
+// Second pass, over blocks of columns
+static void integral_columnSums(void *ctx, int begin, int end) {
+    t_integral *table = ((t_integral_args *)ctx)->table;
+    size_t first = (size_t)begin * INTEGRAL_COLUMN_BLOCK;
+    size_t last = (size_t)end * INTEGRAL_COLUMN_BLOCK;
+    if (last > table->stride) last = table->stride;
+
+    integral_accumulate(table->sum, table->sumWide, table->stride, table->height, first, last);
+    if (table->squares) {
+        integral_accumulate(table->squares, table->squaresWide, table->stride, table->height, first, last);
+    }
+}
+
+t_integral *integral_build(uint8_t **rows, int width, int height, int channels, int withSquares) {
+    if (!rows || width <= 0 || height <= 0 || channels <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return NULL;
+    }
+
+    t_integral *table = (t_integral *)malloc(sizeof(t_integral));
+    if (!table) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    table->width = width;
+    table->height = height;
+    table->channels = channels;
+    table->stride = (size_t)(width + 1) * channels;
+    table->sumWide = integral_needsWide(width, height, 255);
+    table->squaresWide = integral_needsWide(width, height, 255 * 255);
+    table->sum = integral_allocate(table, table->sumWide);
+    table->squares = withSquares ? integral_allocate(table, table->squaresWide) : NULL;
+    if (!table->sum || (withSquares && !table->squares)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        integral_free(table);
+        return NULL;
+    }
+
+    t_integral_args args = {rows, table};
+    scheduler_parallelFor(0, height, scheduler_rowGrain(width * channels), integral_rowSums, &args);
+
+    int blocks = (int)((table->stride + INTEGRAL_COLUMN_BLOCK - 1) / INTEGRAL_COLUMN_BLOCK);
+    scheduler_parallelFor(0, blocks, 1, integral_columnSums, &args);
+
+    return table;
+}
+
+void integral_free(t_integral *table) {
+    if (table) {
+        pool_release(table->sum);
+        pool_release(table->squares);
+        free(table);
+    }
+}
+
+static uint64_t integral_rect(const void *data, int wide, const t_integral *table,
+                              int x0, int y0, int x1, int y1, int channel) {
+    size_t top = (size_t)y0 * table->stride;
+    size_t bottom = (size_t)y1 * table->stride;
+    size_t left = (size_t)x0 * table->channels + channel;
+    size_t right = (size_t)x1 * table->channels + channel;
+
+    if (wide) {
+        const uint64_t *s = (const uint64_t *)data;
+        return s[bottom + right] - s[top + right] - s[bottom + left] + s[top + left];
+    }
+    // Wrapping 32-bit arithmetic still gives the exact rectangle sum, since
+    // no rectangle sums to more than the whole image
+    const uint32_t *s = (const uint32_t *)data;
+    return (uint32_t)(s[bottom + right] - s[top + right] - s[bottom + left] + s[top + left]);
+}
+
+uint64_t integral_sum(const t_integral *table, int x0, int y0, int x1, int y1, int channel) {
+    return integral_rect(table->sum, table->sumWide, table, x0, y0, x1, y1, channel);
+}
+
+uint64_t integral_sumSquares(const t_integral *table, int x0, int y0, int x1, int y1, int channel) {
+    if (!table->squares) return 0;
+    return integral_rect(table->squares, table->squaresWide, table, x0, y0, x1, y1, channel);
+}
@@ -0,0 +1,34 @@
+#ifndef INTEGRAL_H
+#define INTEGRAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Summed-area table: entry (x, y) holds the sum of every sample above and
+// to the left of pixel (x, y), so any rectangle sums in four lookups. The
+// table has a zero first row and column, and channels stay interleaved.
+// Entries are 32-bit when the sum of the whole image fits, 64-bit otherwise;
+// the squared-sum table, used for local variance, chooses on its own.
+typedef struct {
+    int width;
+    int height;
+    int channels;
+    size_t stride;        // Entries per table row, (width + 1) * channels
+    int sumWide;          // sum holds uint64_t entries instead of uint32_t
+    int squaresWide;
+    void *sum;
+    void *squares;        // NULL unless requested
+} t_integral;
+
+// Builds the tables in two parallel passes: prefix sums along each row,
+// then accumulation down blocks of columns.
+// rows[y] points to width pixels of channels interleaved 8-bit samples.
+t_integral *integral_build(uint8_t **rows, int width, int height, int channels, int withSquares);
+void integral_free(t_integral *table);
+
+// Sums over the pixels [x0, x1) x [y0, y1) of one channel. The rectangle
+// must lie inside the image.
+uint64_t integral_sum(const t_integral *table, int x0, int y0, int x1, int y1, int channel);
+uint64_t integral_sumSquares(const t_integral *table, int x0, int y0, int x1, int y1, int channel);
+
+#endif // INTEGRAL_H
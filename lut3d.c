@@ -0,0 +1,310 @@
+#include "lut3d.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+// uint16_t samples per lattice entry: red, green, blue and padding, so
+// that an entry never straddles two cache lines
+#define LUT3D_ENTRY 4
+
+typedef struct {
+    t_lut3d *lut;
+    const t_lut3d_step *steps;
+    int count;
+} t_lut3d_buildArgs;
+
+typedef struct {
+    const t_lut3d *lut;
+    uint8_t **rows;
+    int width;
+    t_lut3d_interpolation mode;
+    uint32_t offset[3][256];   // Table index of the lattice point at or below each value
+    uint16_t weight[3][256];   // Weight of the point above, out of 256
+} t_lut3d_applyArgs;
+
+static t_lut3d *lut3d_allocate(int size) {
+    if (size < 2 || size > LUT3D_MAX_SIZE) {
+        fprintf(stderr, "Error: Invalid LUT size %d\n", size);
+        return NULL;
+    }
+
+    t_lut3d *lut = (t_lut3d *)malloc(sizeof(t_lut3d));
+    if (!lut) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+    lut->table = (uint16_t *)malloc((size_t)size * size * size * LUT3D_ENTRY * sizeof(uint16_t));
+    if (!lut->table) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(lut);
+        return NULL;
+    }
+
+    lut->size = size;
+    for (int c = 0; c < 3; c++) {
+        lut->domainMin[c] = 0.0f;
+        lut->domainMax[c] = 1.0f;
+    }
+    return lut;
+}
+
+void lut3d_free(t_lut3d *lut) {
+    if (lut) {
+        free(lut->table);
+        free(lut);
+    }
+}
+
+// Stores a color of 0 to 255 per channel at entry index
+static void lut3d_store(t_lut3d *lut, size_t index, const float rgb[3]) {
+    uint16_t *entry = lut->table + index * LUT3D_ENTRY;
+    for (int c = 0; c < 3; c++) {
+        float value = rgb[c] < 0.0f ? 0.0f : rgb[c] > 255.0f ? 255.0f : rgb[c];
+        entry[c] = (uint16_t)lroundf(value * 256.0f);
+    }
+    entry[3] = 0;
+}
+
+// Tasks own slices of constant blue
+static void lut3d_buildSlices(void *ctx, int begin, int end) {
+    t_lut3d_buildArgs *args = (t_lut3d_buildArgs *)ctx;
+    int size = args->lut->size;
+    float step = 255.0f / (size - 1);
+
+    for (int b = begin; b < end; b++) {
+        for (int g = 0; g < size; g++) {
+            for (int r = 0; r < size; r++) {
+                float rgb[3] = {r * step, g * step, b * step};
+                for (int i = 0; i < args->count; i++) args->steps[i].apply(rgb, args->steps[i].ctx);
+                lut3d_store(args->lut, ((size_t)b * size + g) * size + r, rgb);
+            }
+        }
+    }
+}
+
+t_lut3d *lut3d_build(int size, const t_lut3d_step *steps, int count) {
+    if ((!steps && count > 0) || count < 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return NULL;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!steps[i].apply) {
+            fprintf(stderr, "Error: Invalid parameters\n");
+            return NULL;
+        }
+    }
+
+    t_lut3d *lut = lut3d_allocate(size);
+    if (!lut) return NULL;
+
+    t_lut3d_buildArgs args = {lut, steps, count};
+    scheduler_parallelFor(0, size, 1, lut3d_buildSlices, &args);
+    return lut;
+}
+
+// Whether line starts with keyword followed by a blank
+static int lut3d_keyword(const char *line, const char *keyword, const char **rest) {
+    size_t length = strlen(keyword);
+    if (strncmp(line, keyword, length) != 0 || !isspace((unsigned char)line[length])) return 0;
+    *rest = line + length;
+    return 1;
+}
+
+t_lut3d *lut3d_load(const char *filename) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open file %s\n", filename);
+        return NULL;
+    }
+
+    t_lut3d *lut = NULL;
+    float domainMin[3] = {0.0f, 0.0f, 0.0f};
+    float domainMax[3] = {1.0f, 1.0f, 1.0f};
+    size_t entries = 0, expected = 0;
+    int lineNumber = 0, failed = 0;
+    char line[512];
+
+    while (!failed && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        const char *p = line;
+        const char *rest;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0' || *p == '#') continue;
+
+        if (lut3d_keyword(p, "TITLE", &rest)) {
+            continue;
+        } else if (lut3d_keyword(p, "LUT_3D_SIZE", &rest)) {
+            int size;
+            if (lut || sscanf(rest, "%d", &size) != 1 || !(lut = lut3d_allocate(size))) {
+                failed = 1;
+                continue;
+            }
+            expected = (size_t)size * size * size;
+        } else if (lut3d_keyword(p, "DOMAIN_MIN", &rest)) {
+            if (sscanf(rest, "%f %f %f", &domainMin[0], &domainMin[1], &domainMin[2]) != 3) failed = 1;
+        } else if (lut3d_keyword(p, "DOMAIN_MAX", &rest)) {
+            if (sscanf(rest, "%f %f %f", &domainMax[0], &domainMax[1], &domainMax[2]) != 3) failed = 1;
+        } else if (lut3d_keyword(p, "LUT_1D_SIZE", &rest)) {
+            fprintf(stderr, "Error: 1D LUTs are not supported\n");
+            failed = 1;
+        } else {
+            float rgb[3];
+            if (!lut || entries >= expected || sscanf(p, "%f %f %f", &rgb[0], &rgb[1], &rgb[2]) != 3) {
+                failed = 1;
+                continue;
+            }
+            for (int c = 0; c < 3; c++) rgb[c] *= 255.0f;
+            lut3d_store(lut, entries++, rgb);
+        }
+    }
+    fclose(file);
+
+    for (int c = 0; c < 3; c++) {
+        if (domainMax[c] <= domainMin[c]) failed = 1;
+    }
+    if (failed || !lut || entries != expected) {
+        fprintf(stderr, "Error: Invalid .cube file %s (line %d)\n", filename, lineNumber);
+        lut3d_free(lut);
+        return NULL;
+    }
+
+    memcpy(lut->domainMin, domainMin, sizeof(domainMin));
+    memcpy(lut->domainMax, domainMax, sizeof(domainMax));
+    return lut;
+}
+
+// Blend of the cell corners of one pixel, following the cell diagonal
+// through the tetrahedron that holds it
+static void lut3d_tetrahedral(const uint16_t *c000, uint32_t dr, uint32_t dg, uint32_t db, uint32_t fr,
+                              uint32_t fg, uint32_t fb, uint8_t *out) {
+    uint32_t first, second, w0, w1, w2, w3;
+    const uint16_t *c111 = c000 + dr + dg + db;
+
+    if (fr > fg) {
+        if (fg > fb) {
+            first = dr, second = dr + dg;
+            w0 = 256 - fr, w1 = fr - fg, w2 = fg - fb, w3 = fb;
+        } else if (fr > fb) {
+            first = dr, second = dr + db;
+            w0 = 256 - fr, w1 = fr - fb, w2 = fb - fg, w3 = fg;
+        } else {
+            first = db, second = dr + db;
+            w0 = 256 - fb, w1 = fb - fr, w2 = fr - fg, w3 = fg;
+        }
+    } else {
+        if (fb > fg) {
+            first = db, second = dg + db;
+            w0 = 256 - fb, w1 = fb - fg, w2 = fg - fr, w3 = fr;
+        } else if (fb > fr) {
+            first = dg, second = dg + db;
+            w0 = 256 - fg, w1 = fg - fb, w2 = fb - fr, w3 = fr;
+        } else {
+            first = dg, second = dr + dg;
+            w0 = 256 - fg, w1 = fg - fr, w2 = fr - fb, w3 = fb;
+        }
+    }
+
+    const uint16_t *a = c000 + first;
+    const uint16_t *b = c000 + second;
+    for (int c = 0; c < 3; c++) {
+        out[c] = (uint8_t)((w0 * c000[c] + w1 * a[c] + w2 * b[c] + w3 * c111[c] + 32768) >> 16);
+    }
+}
+
+// Linear blends along red, then green, then blue, rounded back to 8.8
+// between stages to stay within 32 bits
+static void lut3d_trilinear(const uint16_t *c000, uint32_t dr, uint32_t dg, uint32_t db, uint32_t fr,
+                            uint32_t fg, uint32_t fb, uint8_t *out) {
+    for (int c = 0; c < 3; c++) {
+        const uint16_t *p = c000 + c;
+        uint32_t x00 = (p[0] * (256 - fr) + p[dr] * fr + 128) >> 8;
+        uint32_t x10 = (p[dg] * (256 - fr) + p[dg + dr] * fr + 128) >> 8;
+        uint32_t x01 = (p[db] * (256 - fr) + p[db + dr] * fr + 128) >> 8;
+        uint32_t x11 = (p[db + dg] * (256 - fr) + p[db + dg + dr] * fr + 128) >> 8;
+        uint32_t y0 = (x00 * (256 - fg) + x10 * fg + 128) >> 8;
+        uint32_t y1 = (x01 * (256 - fg) + x11 * fg + 128) >> 8;
+        out[c] = (uint8_t)((y0 * (256 - fb) + y1 * fb + 32768) >> 16);
+    }
+}
+
+static void lut3d_applyRows(void *ctx, int begin, int end) {
+    const t_lut3d_applyArgs *args = (const t_lut3d_applyArgs *)ctx;
+    const uint16_t *table = args->lut->table;
+    uint32_t dr = LUT3D_ENTRY;
+    uint32_t dg = dr * args->lut->size;
+    uint32_t db = dg * args->lut->size;
+
+    for (int y = begin; y < end; y++) {
+        uint8_t *p = args->rows[y];
+        for (int x = 0; x < args->width; x++, p += 3) {
+            const uint16_t *c000 = table + args->offset[0][p[0]] + args->offset[1][p[1]] + args->offset[2][p[2]];
+            uint32_t fr = args->weight[0][p[0]];
+            uint32_t fg = args->weight[1][p[1]];
+            uint32_t fb = args->weight[2][p[2]];
+            if (args->mode == LUT3D_TETRAHEDRAL) {
+                lut3d_tetrahedral(c000, dr, dg, db, fr, fg, fb, p);
+            } else {
+                lut3d_trilinear(c000, dr, dg, db, fr, fg, fb, p);
+            }
+        }
+    }
+}
+
+void lut3d_apply(const t_lut3d *lut, uint8_t **rows, int width, int height, t_lut3d_interpolation mode) {
+    if (!lut || !lut->table || !rows || width <= 0 || height <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    t_lut3d_applyArgs *args = (t_lut3d_applyArgs *)malloc(sizeof(t_lut3d_applyArgs));
+    if (!args) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return;
+    }
+    args->lut = lut;
+    args->rows = rows;
+    args->width = width;
+    args->mode = mode;
+
+    // Lattice position of every channel value; the top point is reached
+    // from the cell below it with a full weight
+    int size = lut->size;
+    uint32_t strides[3] = {LUT3D_ENTRY, (uint32_t)LUT3D_ENTRY * size, (uint32_t)LUT3D_ENTRY * size * size};
+    for (int c = 0; c < 3; c++) {
+        double scale = (size - 1) / ((double)lut->domainMax[c] - lut->domainMin[c]);
+        for (int v = 0; v < 256; v++) {
+            double position = (v / 255.0 - lut->domainMin[c]) * scale;
+            position = position < 0 ? 0 : position > size - 1 ? size - 1 : position;
+            int index = (int)position < size - 2 ? (int)position : size - 2;
+            args->offset[c][v] = index * strides[c];
+            args->weight[c][v] = (uint16_t)lround((position - index) * 256);
+        }
+    }
+
+    scheduler_parallelFor(0, height, scheduler_rowGrain(width), lut3d_applyRows, args);
+    free(args);
+}
+
+void lut3d_grayscale(float rgb[3], const void *ctx) {
+    (void)ctx;
+    float gray = 0.299f * rgb[0] + 0.587f * rgb[1] + 0.114f * rgb[2];
+    rgb[0] = rgb[1] = rgb[2] = gray;
+}
+
+void lut3d_brightness(float rgb[3], const void *ctx) {
+    float offset = *(const float *)ctx;
+    for (int c = 0; c < 3; c++) rgb[c] += offset;
+}
+
+void lut3d_curves(float rgb[3], const void *ctx) {
+    const uint8_t (*curves)[256] = (const uint8_t (*)[256])ctx;
+    for (int c = 0; c < 3; c++) {
+        float value = rgb[c] < 0.0f ? 0.0f : rgb[c] > 255.0f ? 255.0f : rgb[c];
+        int index = (int)value < 255 ? (int)value : 254;
+        float fraction = value - index;
+        rgb[c] = curves[c][index] + (curves[c][index + 1] - curves[c][index]) * fraction;
+    }
+}
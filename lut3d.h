@@ -0,0 +1,62 @@
+#ifndef LUT3D_H
+#define LUT3D_H
+
+#include <stdint.h>
+
+// Common lattice sizes; any size from 2 to LUT3D_MAX_SIZE works
+#define LUT3D_SMALL 17
+#define LUT3D_MEDIUM 33
+#define LUT3D_LARGE 65
+#define LUT3D_MAX_SIZE 256
+
+// 3D color lookup table: a size x size x size lattice of output colors
+// over the input cube, interpolated between lattice points. A chain of
+// per-pixel color operations sampled into a table costs one pass over the
+// image, whatever its length.
+typedef struct {
+    int size;
+    float domainMin[3];   // Input range covered by the lattice, 0 to 1
+    float domainMax[3];   // by default, in red, green, blue order
+    uint16_t *table;      // size^3 entries of red, green, blue and padding,
+                          // in 8.8 fixed point; red varies fastest
+} t_lut3d;
+
+typedef enum {
+    LUT3D_TRILINEAR,      // Blend of the 8 corners of the enclosing cell
+    LUT3D_TETRAHEDRAL     // Blend of 4 of them, cheaper and neutral-preserving
+} t_lut3d_interpolation;
+
+// One color operation of a chain: rgb holds red, green, blue from 0 to
+// 255, modified in place; values past the range are clamped at the end of
+// the chain only
+typedef void (*t_lut3d_op)(float rgb[3], const void *ctx);
+
+typedef struct {
+    t_lut3d_op apply;
+    const void *ctx;
+} t_lut3d_step;
+
+// Table of count steps applied in order, sampled at every lattice point.
+// Steps run in parallel on different points and must not share state.
+t_lut3d *lut3d_build(int size, const t_lut3d_step *steps, int count);
+
+// Reads an Adobe/Resolve .cube file (LUT_3D_SIZE, DOMAIN_MIN, DOMAIN_MAX,
+// TITLE and comments); 1D tables are not supported. Returns NULL on error.
+t_lut3d *lut3d_load(const char *filename);
+
+void lut3d_free(t_lut3d *lut);
+
+// Maps every pixel of the image in place, in parallel over rows. Lattice
+// coordinates come from per-channel tables, and weights are 8-bit.
+// rows[y] points to width interleaved red, green, blue pixels.
+void lut3d_apply(const t_lut3d *lut, uint8_t **rows, int width, int height, t_lut3d_interpolation mode);
+
+// Stock steps. lut3d_grayscale takes the BT.601 luma like bmp24_grayscale;
+// lut3d_brightness adds the float at ctx; lut3d_curves maps each channel
+// through its row of a const uint8_t[3][256] at ctx, interpolating
+// between entries.
+void lut3d_grayscale(float rgb[3], const void *ctx);
+void lut3d_brightness(float rgb[3], const void *ctx);
+void lut3d_curves(float rgb[3], const void *ctx);
+
+#endif // LUT3D_H
@@ -1,7 +1,27 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "bmp8.h"
 #include "bmp24.h"
+#include "batch.h"
+#include "bilateral.h"
+#include "clahe.h"
+#include "edges.h"
+#include "fft.h"
+#include "guided.h"
+#include "pool.h"
+#include "profile.h"
+
+static const char *filterNames[] = {
+    "", "Negative", "Brightness", "Black and white", "Box blur", "Gaussian blur",
+    "Sharpness", "Outline", "Emboss", "Histogram equalization", "Gaussian blur (sigma)",
+    "Median", "Erosion", "Dilation", "Opening", "Closing",
+    "Sauvola threshold", "Bradley threshold", "Otsu threshold", "CLAHE",
+    "Unsharp mask", "Sobel edges", "Canny edges",
+    "Bilateral smoothing", "Guided filter", "Resize", "Rotation",
+    "Horizontal flip", "Vertical flip", "Transpose", "Rotation (any angle)", "Dithering"
+};
+#define FILTER_COUNT 31
 
 void printMenu() {
     printf("\nPlease choose an option:\n");
@@ -24,15 +44,433 @@ void printFilterMenu() {
     printf("7. Outline\n");
     printf("8. Emboss\n");
     printf("9. Histogram Equalization\n");
-    printf("10. Return to the previous menu\n");
+    printf("10. Gaussian blur (any sigma)\n");
+    printf("11. Median (noise removal)\n");
+    printf("12. Erosion (8-bit)\n");
+    printf("13. Dilation (8-bit)\n");
+    printf("14. Opening (8-bit)\n");
+    printf("15. Closing (8-bit)\n");
+    printf("16. Adaptive threshold, Sauvola (8-bit)\n");
+    printf("17. Adaptive threshold, Bradley (8-bit)\n");
+    printf("18. Automatic threshold, Otsu (8-bit)\n");
+    printf("19. Adaptive equalization (CLAHE)\n");
+    printf("20. Unsharp mask\n");
+    printf("21. Sobel edges (8-bit)\n");
+    printf("22. Canny edges (8-bit)\n");
+    printf("23. Bilateral smoothing\n");
+    printf("24. Guided filter\n");
+    printf("25. Resize\n");
+    printf("26. Rotate clockwise (90, 180 or 270 degrees)\n");
+    printf("27. Flip horizontally\n");
+    printf("28. Flip vertically\n");
+    printf("29. Transpose\n");
+    printf("30. Rotate clockwise by any angle (e.g. deskew)\n");
+    printf("31. Dither for print, Floyd-Steinberg (8-bit)\n");
+    printf("32. Return to the previous menu\n");
     printf(">>> Your choice: ");
 }
 
-int main() {
+void printUsage(const char *program) {
+    printf("Usage: %s [--profile] [--pool-limit <MB>] [--fft-crossover <size>]\n", program);
+    printf("       %s [options] --batch <filter> [--value <x>] <output dir> <file>...\n", program);
+    printf("Filters are numbered as in the interactive filter menu.\n");
+}
+
+// Side length scaled for resizing by a positive scale, at least one pixel
+int scaledSize(int size, float scale) {
+    int scaled = (int)(size * scale + 0.5f);
+    return scaled > 0 ? scaled : 1;
+}
+
+// Puts the result of a filter that returns a new image in place of img.
+// Returns 0 if the filter failed and returned NULL.
+int replaceGrayImage(t_bmp8 *img, t_bmp8 *result) {
+    if (!result) return 0;
+
+    t_bmp8 previous = *img;
+    *img = *result;
+    *result = previous;
+    bmp8_free(result);
+    return 1;
+}
+
+int replaceColorImage(t_bmp24 *img, t_bmp24 *result) {
+    if (!result) return 0;
+
+    t_bmp24 previous = *img;
+    *img = *result;
+    *result = previous;
+    bmp24_free(result);
+    return 1;
+}
+
+// Returns 0 if the filter did not run on img
+int applyGrayFilter(t_bmp8 *img, int filterChoice, float value) {
+    switch (filterChoice) {
+        case 1:
+            bmp8_negative(img);
+            break;
+        case 2:
+            bmp8_brightness(img, (int)value);
+            break;
+        case 3:
+            bmp8_threshold(img, (int)value);
+            break;
+        case 4:
+            // Box blur kernel
+            {
+                float *kernel[3];
+                float k[3][3] = {
+                    {1.0f/9, 1.0f/9, 1.0f/9},
+                    {1.0f/9, 1.0f/9, 1.0f/9},
+                    {1.0f/9, 1.0f/9, 1.0f/9}
+                };
+                for (int i = 0; i < 3; i++) kernel[i] = k[i];
+                bmp8_applyFilter(img, kernel, 3);
+            }
+            break;
+        case 5:
+            // Gaussian blur kernel
+            {
+                float *kernel[3];
+                float k[3][3] = {
+                    {1.0f/16, 2.0f/16, 1.0f/16},
+                    {2.0f/16, 4.0f/16, 2.0f/16},
+                    {1.0f/16, 2.0f/16, 1.0f/16}
+                };
+                for (int i = 0; i < 3; i++) kernel[i] = k[i];
+                bmp8_applyFilter(img, kernel, 3);
+            }
+            break;
+        case 6:
+            // Sharpen kernel
+            {
+                float *kernel[3];
+                float k[3][3] = {
+                    {0, -1, 0},
+                    {-1, 5, -1},
+                    {0, -1, 0}
+                };
+                for (int i = 0; i < 3; i++) kernel[i] = k[i];
+                bmp8_applyFilter(img, kernel, 3);
+            }
+            break;
+        case 7:
+            // Outline kernel
+            {
+                float *kernel[3];
+                float k[3][3] = {
+                    {-1, -1, -1},
+                    {-1, 8, -1},
+                    {-1, -1, -1}
+                };
+                for (int i = 0; i < 3; i++) kernel[i] = k[i];
+                bmp8_applyFilter(img, kernel, 3);
+            }
+            break;
+        case 8:
+            // Emboss kernel
+            {
+                float *kernel[3];
+                float k[3][3] = {
+                    {-1, 1, 1},
+                    {-2, -1, 0},
+                    {0, 1, 2}
+                };
+                for (int i = 0; i < 3; i++) kernel[i] = k[i];
+                bmp8_applyFilter(img, kernel, 3);
+            }
+            break;
+        case 9:
+            {
+                unsigned int *hist = bmp8_computeHistogram(img);
+                unsigned int *hist_eq = bmp8_computeCDF(hist);
+                bmp8_equalize(img, hist_eq);
+                free(hist);
+                free(hist_eq);
+            }
+            break;
+        case 10:
+            bmp8_gaussianBlurSigma(img, value);
+            break;
+        case 11:
+            bmp8_median(img, (int)value);
+            break;
+        case 12:
+            bmp8_erode(img, (int)value, (int)value);
+            break;
+        case 13:
+            bmp8_dilate(img, (int)value, (int)value);
+            break;
+        case 14:
+            bmp8_open(img, (int)value, (int)value);
+            break;
+        case 15:
+            bmp8_close(img, (int)value, (int)value);
+            break;
+        case 16:
+            bmp8_thresholdSauvola(img, (int)value, 0.34f);
+            break;
+        case 17:
+            bmp8_thresholdBradley(img, (int)value, 0.15f);
+            break;
+        case 18:
+            bmp8_thresholdOtsu(img);
+            break;
+        case 19:
+            bmp8_clahe(img, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_TILES, value);
+            break;
+        case 20:
+            bmp8_unsharpMask(img, value, 1.0f, 2);
+            break;
+        case 21:
+            return replaceGrayImage(img, bmp8_sobel(img));
+        case 22:
+            return replaceGrayImage(img, bmp8_canny(img, value, EDGES_DEFAULT_LOW, EDGES_DEFAULT_HIGH));
+        case 23:
+            bmp8_bilateral(img, value, BILATERAL_DEFAULT_RANGE, BILATERAL_DEFAULT_SAMPLES);
+            break;
+        case 24:
+            bmp8_guidedFilter(img, (int)value, GUIDED_DEFAULT_EPSILON);
+            break;
+        case 25:
+            if (value <= 0) {
+                fprintf(stderr, "Error: Scale factor must be positive\n");
+                return 0;
+            }
+            return replaceGrayImage(img, bmp8_resize(img, scaledSize(img->width, value),
+                                                     scaledSize(img->height, value), RESIZE_LANCZOS3));
+        case 26:
+            if ((int)value == 90) bmp8_rotate90(img);
+            else if ((int)value == 180) bmp8_rotate180(img);
+            else if ((int)value == 270) bmp8_rotate270(img);
+            else {
+                fprintf(stderr, "Error: Rotation must be 90, 180 or 270 degrees\n");
+                return 0;
+            }
+            break;
+        case 27:
+            bmp8_flipH(img);
+            break;
+        case 28:
+            bmp8_flipV(img);
+            break;
+        case 29:
+            bmp8_transpose(img);
+            break;
+        case 30:
+            bmp8_rotateAngle(img, value, 255);
+            break;
+        case 31:
+            bmp8_dither(img, (int)value, DITHER_FLOYD_STEINBERG);
+            break;
+    }
+    return 1;
+}
+
+int applyColorFilter(t_bmp24 *img, int filterChoice, float value) {
+    switch (filterChoice) {
+        case 1:
+            bmp24_negative(img);
+            break;
+        case 2:
+            bmp24_brightness(img, (int)value);
+            break;
+        case 3:
+            bmp24_grayscale(img);
+            break;
+        case 4:
+            bmp24_boxBlur(img);
+            break;
+        case 5:
+            bmp24_gaussianBlur(img);
+            break;
+        case 6:
+            bmp24_sharpen(img);
+            break;
+        case 7:
+            bmp24_outline(img);
+            break;
+        case 8:
+            bmp24_emboss(img);
+            break;
+        case 9:
+            bmp24_equalize(img);
+            break;
+        case 10:
+            bmp24_gaussianBlurSigma(img, value);
+            break;
+        case 11:
+            bmp24_median(img, (int)value);
+            break;
+        case 19:
+            bmp24_clahe(img, CLAHE_DEFAULT_TILES, CLAHE_DEFAULT_TILES, value);
+            break;
+        case 20:
+            bmp24_unsharpMask(img, value, 1.0f, 2);
+            break;
+        case 23:
+            bmp24_bilateral(img, value, BILATERAL_DEFAULT_RANGE, BILATERAL_DEFAULT_SAMPLES);
+            break;
+        case 24:
+            bmp24_guidedFilter(img, (int)value, GUIDED_DEFAULT_EPSILON);
+            break;
+        case 25:
+            if (value <= 0) {
+                fprintf(stderr, "Error: Scale factor must be positive\n");
+                return 0;
+            }
+            return replaceColorImage(img, bmp24_resize(img, scaledSize(img->width, value),
+                                                       scaledSize(img->height, value), RESIZE_LANCZOS3));
+        case 26:
+            if ((int)value == 90) bmp24_rotate90(img);
+            else if ((int)value == 180) bmp24_rotate180(img);
+            else if ((int)value == 270) bmp24_rotate270(img);
+            else {
+                fprintf(stderr, "Error: Rotation must be 90, 180 or 270 degrees\n");
+                return 0;
+            }
+            break;
+        case 27:
+            bmp24_flipH(img);
+            break;
+        case 28:
+            bmp24_flipV(img);
+            break;
+        case 29:
+            bmp24_transpose(img);
+            break;
+        case 30:
+            bmp24_rotateAngle(img, value, (t_pixel){255, 255, 255});
+            break;
+        default:
+            fprintf(stderr, "Error: %s is only available for 8-bit images\n", filterNames[filterChoice]);
+            return 0;
+    }
+    return 1;
+}
+
+typedef struct {
+    int filterChoice;
+    float value;
+    uint64_t pixels;
+} t_batch_options;
+
+// Images are filtered concurrently, so the profile covers the whole batch
+int applyBatchFilter(t_batch_item *item, void *ctx) {
+    t_batch_options *options = (t_batch_options *)ctx;
+
+    if (item->gray) {
+        __atomic_fetch_add(&options->pixels, (uint64_t)item->gray->width * item->gray->height, __ATOMIC_RELAXED);
+        return applyGrayFilter(item->gray, options->filterChoice, options->value);
+    }
+    __atomic_fetch_add(&options->pixels, (uint64_t)item->color->width * item->color->height, __ATOMIC_RELAXED);
+    return applyColorFilter(item->color, options->filterChoice, options->value);
+}
+
+int runBatch(const char *program, int argc, char *argv[]) {
+    t_batch_options options = {0, 0, 0};
+    t_profile prof;
+    const char *outputDir = NULL;
+    const char **inputs = (const char **)malloc(argc * sizeof(char *));
+    int count = 0;
+
+    if (!inputs) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 1;
+    }
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--value") == 0 && i + 1 < argc) {
+            options.value = (float)atof(argv[++i]);
+        } else if ((strcmp(argv[i], "--pool-limit") == 0 || strcmp(argv[i], "--fft-crossover") == 0) && i + 1 < argc) {
+            i++;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            continue;
+        } else if (options.filterChoice == 0) {
+            options.filterChoice = atoi(argv[i]);
+        } else if (!outputDir) {
+            outputDir = argv[i];
+        } else {
+            inputs[count++] = argv[i];
+        }
+    }
+
+    if (options.filterChoice < 1 || options.filterChoice > FILTER_COUNT || !outputDir || count == 0) {
+        printUsage(program);
+        free(inputs);
+        return 1;
+    }
+    // Checked once here rather than failing on every image
+    if (options.filterChoice == 25 && options.value <= 0) {
+        fprintf(stderr, "Error: Resizing needs a positive --value scale factor\n");
+        free(inputs);
+        return 1;
+    }
+
+    // Output files keep their input name inside the output directory
+    char **outputs = (char **)malloc(count * sizeof(char *));
+    if (!outputs) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(inputs);
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        const char *name = strrchr(inputs[i], '/');
+        name = name ? name + 1 : inputs[i];
+        outputs[i] = (char *)malloc(strlen(outputDir) + strlen(name) + 2);
+        if (!outputs[i]) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            while (i-- > 0) free(outputs[i]);
+            free(outputs);
+            free(inputs);
+            return 1;
+        }
+        sprintf(outputs[i], "%s/%s", outputDir, name);
+    }
+
+    profile_begin(&prof);
+    int saved = batch_run(inputs, (const char **)outputs, count, applyBatchFilter, &options, 4);
+    profile_end(&prof, "Batch (load, filter, save)", options.pixels);
+    printf("%d of %d images processed\n", saved, count);
+
+    for (int i = 0; i < count; i++) free(outputs[i]);
+    free(outputs);
+    free(inputs);
+    return saved == count ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
     t_bmp8 *grayImage = NULL;
     t_bmp24 *colorImage = NULL;
     char filename[256];
-    int choice, filterChoice, value;
+    int choice, filterChoice;
+    float value = 0;
+    t_profile prof;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--profile") == 0) {
+            // Opt-in hardware counter profiling of each filter call
+            profile_init();
+        } else if (strcmp(argv[i], "--pool-limit") == 0 && i + 1 < argc) {
+            // Idle image buffers kept for reuse, in megabytes
+            pool_setLimit((size_t)atol(argv[++i]) * 1024 * 1024);
+        } else if (strcmp(argv[i], "--fft-crossover") == 0 && i + 1 < argc) {
+            // Kernel size from which filters use the FFT, as measured by benchmark
+            fft_setCrossover(atoi(argv[++i]));
+        }
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0) {
+            int status = runBatch(argv[0], argc - i - 1, argv + i + 1);
+            profile_shutdown();
+            return status;
+        } else if (strcmp(argv[i], "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        }
+    }
 
     while (1) {
         printMenu();
@@ -63,11 +501,13 @@ int main() {
                 scanf("%255s", filename);
 
                 if (grayImage) {
-                    bmp8_saveImage(filename, grayImage);
-                    printf("8-bit grayscale image saved successfully!\n");
+                    if (bmp8_saveImage(filename, grayImage)) {
+                        printf("8-bit grayscale image saved successfully!\n");
+                    }
                 } else if (colorImage) {
-                    bmp24_saveImage(colorImage, filename);
-                    printf("24-bit color image saved successfully!\n");
+                    if (bmp24_saveImage(colorImage, filename)) {
+                        printf("24-bit color image saved successfully!\n");
+                    }
                 } else {
                     printf("Error: No image loaded\n");
                 }
@@ -77,131 +517,62 @@ int main() {
                 printFilterMenu();
                 scanf("%d", &filterChoice);
 
+                if (filterChoice < 1 || filterChoice > FILTER_COUNT) {
+                    if (filterChoice != FILTER_COUNT + 1) printf("Invalid filter choice\n");
+                    continue;
+                }
+
+                // Read parameters up front so the profile only covers the filter itself
+                if (filterChoice == 2) {
+                    printf("Enter brightness value (-255 to 255): ");
+                    scanf("%f", &value);
+                } else if (filterChoice == 3 && grayImage) {
+                    printf("Enter threshold value (0 to 255): ");
+                    scanf("%f", &value);
+                } else if (filterChoice == 10 || filterChoice == 20) {
+                    printf("Enter sigma (> 0): ");
+                    scanf("%f", &value);
+                } else if (filterChoice >= 11 && filterChoice <= 15) {
+                    printf("Enter radius (1 to 15): ");
+                    scanf("%f", &value);
+                } else if (filterChoice == 16 || filterChoice == 17) {
+                    printf("Enter window radius (e.g. 15): ");
+                    scanf("%f", &value);
+                } else if (filterChoice == 22) {
+                    printf("Enter blur sigma (e.g. %.1f, 0 for none): ", EDGES_DEFAULT_SIGMA);
+                    scanf("%f", &value);
+                } else if (filterChoice == 23) {
+                    printf("Enter spatial sigma (e.g. 8): ");
+                    scanf("%f", &value);
+                } else if (filterChoice == 24) {
+                    printf("Enter window radius (e.g. 8): ");
+                    scanf("%f", &value);
+                } else if (filterChoice == 25) {
+                    printf("Enter scale factor (e.g. 0.5): ");
+                    scanf("%f", &value);
+                } else if (filterChoice == 26) {
+                    printf("Enter angle (90, 180 or 270): ");
+                    scanf("%f", &value);
+                } else if (filterChoice == 30) {
+                    printf("Enter angle in degrees (e.g. 2.5, negative for counterclockwise): ");
+                    scanf("%f", &value);
+                } else if (filterChoice == 31) {
+                    printf("Enter number of gray levels (2 for black and white): ");
+                    scanf("%f", &value);
+                } else if (filterChoice == 19) {
+                    printf("Enter clip limit (e.g. %.1f, 0 for none): ", CLAHE_DEFAULT_CLIP);
+                    scanf("%f", &value);
+                }
+
+                profile_begin(&prof);
                 if (grayImage) {
-                    switch (filterChoice) {
-                        case 1:
-                            bmp8_negative(grayImage);
-                            break;
-                        case 2:
-                            printf("Enter brightness value (-255 to 255): ");
-                            scanf("%d", &value);
-                            bmp8_brightness(grayImage, value);
-                            break;
-                        case 3:
-                            printf("Enter threshold value (0 to 255): ");
-                            scanf("%d", &value);
-                            bmp8_threshold(grayImage, value);
-                            break;
-                        case 4:
-                            // Box blur kernel
-                            {
-                                float *kernel[3];
-                                float k[3][3] = {
-                                    {1.0f/9, 1.0f/9, 1.0f/9},
-                                    {1.0f/9, 1.0f/9, 1.0f/9},
-                                    {1.0f/9, 1.0f/9, 1.0f/9}
-                                };
-                                for (int i = 0; i < 3; i++) kernel[i] = k[i];
-                                bmp8_applyFilter(grayImage, kernel, 3);
-                            }
-                            break;
-                        case 5:
-                            // Gaussian blur kernel
-                            {
-                                float *kernel[3];
-                                float k[3][3] = {
-                                    {1.0f/16, 2.0f/16, 1.0f/16},
-                                    {2.0f/16, 4.0f/16, 2.0f/16},
-                                    {1.0f/16, 2.0f/16, 1.0f/16}
-                                };
-                                for (int i = 0; i < 3; i++) kernel[i] = k[i];
-                                bmp8_applyFilter(grayImage, kernel, 3);
-                            }
-                            break;
-                        case 6:
-                            // Sharpen kernel
-                            {
-                                float *kernel[3];
-                                float k[3][3] = {
-                                    {0, -1, 0},
-                                    {-1, 5, -1},
-                                    {0, -1, 0}
-                                };
-                                for (int i = 0; i < 3; i++) kernel[i] = k[i];
-                                bmp8_applyFilter(grayImage, kernel, 3);
-                            }
-                            break;
-                        case 7:
-                            // Outline kernel
-                            {
-                                float *kernel[3];
-                                float k[3][3] = {
-                                    {-1, -1, -1},
-                                    {-1, 8, -1},
-                                    {-1, -1, -1}
-                                };
-                                for (int i = 0; i < 3; i++) kernel[i] = k[i];
-                                bmp8_applyFilter(grayImage, kernel, 3);
-                            }
-                            break;
-                        case 8:
-                            // Emboss kernel
-                            {
-                                float *kernel[3];
-                                float k[3][3] = {
-                                    {-1, 1, 1},
-                                    {-2, -1, 0},
-                                    {0, 1, 2}
-                                };
-                                for (int i = 0; i < 3; i++) kernel[i] = k[i];
-                                bmp8_applyFilter(grayImage, kernel, 3);
-                            }
-                            break;
-                        case 9:
-                            continue;
-                        default:
-                            printf("Invalid filter choice\n");
-                            continue;
-                    }
-                    printf("Filter applied successfully!\n");
+                    int applied = applyGrayFilter(grayImage, filterChoice, value);
+                    profile_end(&prof, filterNames[filterChoice], (uint64_t)grayImage->width * grayImage->height);
+                    if (applied) printf("Filter applied successfully!\n");
                 } else if (colorImage) {
-                    switch (filterChoice) {
-                        case 1:
-                            bmp24_negative(colorImage);
-                            break;
-                        case 2:
-                            printf("Enter brightness value (-255 to 255): ");
-                            scanf("%d", &value);
-                            bmp24_brightness(colorImage, value);
-                            break;
-                        case 3:
-                            bmp24_grayscale(colorImage);
-                            break;
-                        case 4:
-                            bmp24_boxBlur(colorImage);
-                            break;
-                        case 5:
-                            bmp24_gaussianBlur(colorImage);
-                            break;
-                        case 6:
-                            bmp24_sharpen(colorImage);
-                            break;
-                        case 7:
-                            bmp24_outline(colorImage);
-                            break;
-                        case 8:
-                            bmp24_emboss(colorImage);
-                            break;
-                        case 9:
-                            bmp24_equalize(colorImage);
-                        break;
-                        case 10:
-                            continue;
-                        default:
-                            printf("Invalid filter choice\n");
-                            continue;
-                    }
-                    printf("Filter applied successfully!\n");
+                    int applied = applyColorFilter(colorImage, filterChoice, value);
+                    profile_end(&prof, filterNames[filterChoice], (uint64_t)colorImage->width * colorImage->height);
+                    if (applied) printf("Filter applied successfully!\n");
                 } else {
                     printf("Error: No image loaded\n");
                 }
@@ -223,6 +594,7 @@ int main() {
             case 5: // Quit
                 if (grayImage) bmp8_free(grayImage);
                 if (colorImage) bmp24_free(colorImage);
+                profile_shutdown();
                 return 0;
 
             default:
@@ -232,4 +604,4 @@ int main() {
     }
 
     return 0;
-}
\ No newline at end of file
+}
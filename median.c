@@ -0,0 +1,189 @@
+#include "median.h"
+#include "pool.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Output columns per task; each strip also keeps radius extra columns of
+// histograms on both sides
+#define MEDIAN_STRIP 256
+
+// 16 bins of 16-bit counts, added and subtracted as one vector
+typedef uint16_t t_bins16 __attribute__((vector_size(32)));
+
+typedef struct {
+    t_bins16 coarse;     // Counts of values v >> 4
+    t_bins16 fine[16];   // Counts of values v, grouped by v >> 4
+} t_median_hist;
+
+typedef struct {
+    uint8_t **rows;
+    uint8_t *output;
+    size_t outputStride;
+    int width;
+    int height;
+    int channels;
+    int radius;
+    int failed;
+} t_median_args;
+
+static int median_clamp(int v, int low, int high) {
+    return v < low ? low : (v > high ? high : v);
+}
+
+static void median_add(t_median_hist *h, uint8_t v) {
+    h->coarse[v >> 4]++;
+    h->fine[v >> 4][v & 15]++;
+}
+
+static void median_remove(t_median_hist *h, uint8_t v) {
+    h->coarse[v >> 4]--;
+    h->fine[v >> 4][v & 15]--;
+}
+
+// Filters one channel of the columns [x0, x1). cols holds the column
+// histograms of [first, first + count) and column indices outside the image
+// are clamped to its border.
+static void median_strip(t_median_args *args, t_median_hist *cols, int x0, int x1, int channel) {
+    int r = args->radius;
+    int ch = args->channels;
+    int w = args->width;
+    int h = args->height;
+    int first = x0 - r > 0 ? x0 - r : 0;
+    int last = x1 + r < w ? x1 + r : w;
+    int target = (2 * r + 1) * (2 * r + 1) / 2;
+
+#define COLUMN(j) (&cols[median_clamp((j), 0, w - 1) - first])
+
+    memset(cols, 0, (size_t)(last - first) * sizeof(t_median_hist));
+    for (int dy = -r; dy <= r; dy++) {
+        const uint8_t *row = args->rows[median_clamp(dy, 0, h - 1)];
+        for (int x = first; x < last; x++) {
+            median_add(&cols[x - first], row[x * ch + channel]);
+        }
+    }
+
+    for (int y = 0; y < h; y++) {
+        if (y > 0) {
+            int out = median_clamp(y - r - 1, 0, h - 1);
+            int in = median_clamp(y + r, 0, h - 1);
+            if (out != in) {
+                const uint8_t *outRow = args->rows[out];
+                const uint8_t *inRow = args->rows[in];
+                for (int x = first; x < last; x++) {
+                    median_remove(&cols[x - first], outRow[x * ch + channel]);
+                    median_add(&cols[x - first], inRow[x * ch + channel]);
+                }
+            }
+        }
+
+        // The window's fine bins are only brought up to date for the coarse
+        // bin that holds the median, which changes rarely along a row
+        t_median_hist window;
+        int fineAt[16];
+        memset(&window.coarse, 0, sizeof(window.coarse));
+        for (int g = 0; g < 16; g++) fineAt[g] = x0 - 2 * r - 2;
+        for (int j = x0 - r; j <= x0 + r; j++) {
+            window.coarse += COLUMN(j)->coarse;
+        }
+
+        uint8_t *dst = args->output + (size_t)y * args->outputStride;
+        for (int x = x0; x < x1; x++) {
+            if (x > x0) {
+                window.coarse += COLUMN(x + r)->coarse - COLUMN(x - r - 1)->coarse;
+            }
+
+            int sum = 0;
+            int g = 0;
+            while (sum + window.coarse[g] <= target) {
+                sum += window.coarse[g];
+                g++;
+            }
+
+            if (x - fineAt[g] > 2 * r + 1) {
+                memset(&window.fine[g], 0, sizeof(window.fine[g]));
+                for (int j = x - r; j <= x + r; j++) {
+                    window.fine[g] += COLUMN(j)->fine[g];
+                }
+            } else {
+                for (int j = fineAt[g] + 1; j <= x; j++) {
+                    window.fine[g] += COLUMN(j + r)->fine[g] - COLUMN(j - r - 1)->fine[g];
+                }
+            }
+            fineAt[g] = x;
+
+            int b = 0;
+            while (sum + window.fine[g][b] <= target) {
+                sum += window.fine[g][b];
+                b++;
+            }
+            dst[x * ch + channel] = (uint8_t)(g * 16 + b);
+        }
+    }
+
+#undef COLUMN
+}
+
+static void median_strips(void *ctx, int begin, int end) {
+    t_median_args *args = (t_median_args *)ctx;
+    size_t count = MEDIAN_STRIP + 2 * args->radius;
+    t_median_hist *cols = (t_median_hist *)pool_acquire(count * sizeof(t_median_hist));
+    if (!cols) {
+        __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    for (int s = begin; s < end; s++) {
+        int x0 = s * MEDIAN_STRIP;
+        int x1 = x0 + MEDIAN_STRIP < args->width ? x0 + MEDIAN_STRIP : args->width;
+        for (int c = 0; c < args->channels; c++) {
+            median_strip(args, cols, x0, x1, c);
+        }
+    }
+
+    pool_release(cols);
+}
+
+static void median_copyRows(void *ctx, int begin, int end) {
+    t_median_args *args = (t_median_args *)ctx;
+    for (int y = begin; y < end; y++) {
+        memcpy(args->rows[y], args->output + (size_t)y * args->outputStride,
+               (size_t)args->width * args->channels);
+    }
+}
+
+int median_filter(uint8_t **rows, int width, int height, int channels, int radius) {
+    if (!rows || width <= 0 || height <= 0 || channels <= 0 || radius < 1 || radius > MEDIAN_MAX_RADIUS) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    // Strips read columns their neighbours write, so the result goes to a
+    // separate buffer first
+    t_median_args args;
+    args.rows = rows;
+    args.width = width;
+    args.height = height;
+    args.channels = channels;
+    args.radius = radius;
+    args.failed = 0;
+    args.outputStride = POOL_ROW_STRIDE((size_t)width * channels);
+    args.output = (uint8_t *)pool_acquire(args.outputStride * height);
+    if (!args.output) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 0;
+    }
+
+    int strips = (width + MEDIAN_STRIP - 1) / MEDIAN_STRIP;
+    scheduler_parallelFor(0, strips, 1, median_strips, &args);
+
+    if (!args.failed) {
+        scheduler_parallelFor(0, height, scheduler_rowGrain(width * channels), median_copyRows, &args);
+    } else {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+    }
+
+    pool_release(args.output);
+    return !args.failed;
+}
@@ -0,0 +1,19 @@
+#ifndef MEDIAN_H
+#define MEDIAN_H
+
+#include <stdint.h>
+
+// Largest radius whose window count still fits the 16-bit histograms
+#define MEDIAN_MAX_RADIUS 127
+
+// Median over a (2 * radius + 1)^2 window at constant cost per pixel
+// (Perreault & Hebert, "Median Filtering in Constant Time", 2007). Every
+// column keeps a histogram of its window rows, and the window histogram
+// slides right by adding one column histogram and removing another.
+// Histograms are split into 16 coarse and 256 fine bins so finding the
+// median scans at most 32 bins. rows[y] points to width pixels of channels
+// interleaved 8-bit samples; edges are extended with the border pixels.
+// Returns 0 on allocation failure.
+int median_filter(uint8_t **rows, int width, int height, int channels, int radius);
+
+#endif // MEDIAN_H
@@ -0,0 +1,336 @@
+#include "morph.h"
+#include "pool.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Dilation runs as an erosion of the inverted image: samples are XORed with
+// 0xFF on the way in and out, so only minimum code is needed and 255 (all
+// ones for bits) is the neutral value outside the image.
+
+// Bytes of a row handled together by the column pass
+#define MORPH_BLOCK 256
+// 64-bit words of a packed row handled together by the column pass
+#define MORPH_WORD_BLOCK 32
+
+typedef uint8_t t_bytes16 __attribute__((vector_size(16)));
+
+typedef struct {
+    uint8_t **rows;
+    int width;
+    int height;
+    int channels;
+    int radiusX;
+    int radiusY;
+    uint8_t mask;       // 0xFF for dilation
+    uint8_t *plane;     // Result of the row pass, inverted for dilation
+    size_t planeStride;
+    uint64_t *bits;     // Same for packed binary images
+    size_t bitStride;   // Words per packed row
+    int failed;
+} t_morph_args;
+
+static uint8_t morph_min(uint8_t a, uint8_t b) {
+    return a < b ? a : b;
+}
+
+static t_bytes16 morph_minVector(t_bytes16 a, t_bytes16 b) {
+    t_bytes16 lower = (t_bytes16)(a < b);
+    return (a & lower) | (b & ~lower);
+}
+
+static void morph_fail(t_morph_args *args) {
+    __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+}
+
+// van Herk / Gil-Werman over one padded line of n samples: g holds minima
+// from the start of each block of k samples, h minima to its end, and the
+// window starting at i is min(h[i], g[i + k - 1])
+static void morph_line(const uint8_t *p, uint8_t *g, uint8_t *h, int n, int k) {
+    for (int start = 0; start < n; start += k) {
+        int end = start + k < n ? start + k : n;
+        g[start] = p[start];
+        for (int i = start + 1; i < end; i++) g[i] = morph_min(g[i - 1], p[i]);
+        h[end - 1] = p[end - 1];
+        for (int i = end - 2; i >= start; i--) h[i] = morph_min(h[i + 1], p[i]);
+    }
+}
+
+static void morph_rows(void *ctx, int begin, int end) {
+    t_morph_args *args = (t_morph_args *)ctx;
+    int w = args->width;
+    int ch = args->channels;
+    int r = args->radiusX;
+    int k = 2 * r + 1;
+    int n = w + 2 * r;
+
+    uint8_t *scratch = (uint8_t *)malloc((size_t)n * 3);
+    if (!scratch) {
+        morph_fail(args);
+        return;
+    }
+    uint8_t *p = scratch;
+    uint8_t *g = scratch + n;
+    uint8_t *h = scratch + 2 * n;
+    memset(p, 0xFF, r);
+    memset(p + r + w, 0xFF, r);
+
+    for (int y = begin; y < end; y++) {
+        const uint8_t *src = args->rows[y];
+        uint8_t *dst = args->plane + (size_t)y * args->planeStride;
+        for (int c = 0; c < ch; c++) {
+            for (int x = 0; x < w; x++) p[r + x] = src[x * ch + c] ^ args->mask;
+            morph_line(p, g, h, n, k);
+            for (int x = 0; x < w; x++) dst[x * ch + c] = morph_min(h[x], g[x + k - 1]);
+        }
+    }
+
+    free(scratch);
+}
+
+// Column pass over blocks of MORPH_BLOCK bytes. The recurrences run down
+// the rows on whole vectors, so every step handles 16 columns.
+static void morph_columns(void *ctx, int begin, int end) {
+    t_morph_args *args = (t_morph_args *)ctx;
+    int h = args->height;
+    int r = args->radiusY;
+    int k = 2 * r + 1;
+    int n = h + 2 * r;
+    int samples = args->width * args->channels;
+    const int lanes = MORPH_BLOCK / sizeof(t_bytes16);
+
+    t_bytes16 *scratch = (t_bytes16 *)pool_acquire((size_t)n * 2 * MORPH_BLOCK);
+    if (!scratch) {
+        morph_fail(args);
+        return;
+    }
+    t_bytes16 *G = scratch;
+    t_bytes16 *H = scratch + (size_t)n * lanes;
+    t_bytes16 neutral, mask, line[MORPH_BLOCK / sizeof(t_bytes16)];
+    memset(&neutral, 0xFF, sizeof(neutral));
+    memset(&mask, args->mask, sizeof(mask));
+
+#define PADDED_ROW(i) ((i) >= r && (i) < r + h ? args->plane + (size_t)((i) - r) * args->planeStride + x0 : NULL)
+
+    for (int block = begin; block < end; block++) {
+        int x0 = block * MORPH_BLOCK;
+        int x1 = x0 + MORPH_BLOCK < samples ? x0 + MORPH_BLOCK : samples;
+        // Rows of the plane are padded to 64 bytes, so whole vectors can be read
+        int count = (x1 - x0 + sizeof(t_bytes16) - 1) / sizeof(t_bytes16);
+
+        for (int start = 0; start < n; start += k) {
+            int stop = start + k < n ? start + k : n;
+            for (int i = start; i < stop; i++) {
+                const uint8_t *src = PADDED_ROW(i);
+                t_bytes16 *g = G + (size_t)i * lanes;
+                for (int v = 0; v < count; v++) {
+                    t_bytes16 value = neutral;
+                    if (src) memcpy(&value, src + v * sizeof(t_bytes16), sizeof(value));
+                    g[v] = i == start ? value : morph_minVector(g[v - lanes], value);
+                }
+            }
+            for (int i = stop - 1; i >= start; i--) {
+                const uint8_t *src = PADDED_ROW(i);
+                t_bytes16 *hv = H + (size_t)i * lanes;
+                for (int v = 0; v < count; v++) {
+                    t_bytes16 value = neutral;
+                    if (src) memcpy(&value, src + v * sizeof(t_bytes16), sizeof(value));
+                    hv[v] = i == stop - 1 ? value : morph_minVector(hv[v + lanes], value);
+                }
+            }
+        }
+
+        for (int y = 0; y < h; y++) {
+            const t_bytes16 *hv = H + (size_t)y * lanes;
+            const t_bytes16 *g = G + (size_t)(y + k - 1) * lanes;
+            for (int v = 0; v < count; v++) line[v] = morph_minVector(hv[v], g[v]) ^ mask;
+            memcpy(args->rows[y] + x0, line, x1 - x0);
+        }
+    }
+
+#undef PADDED_ROW
+
+    pool_release(scratch);
+}
+
+// Bits starting at the given bit index, across a word boundary if needed
+static uint64_t morph_bitsAt(const uint64_t *words, size_t bit) {
+    size_t word = bit >> 6;
+    unsigned int offset = bit & 63;
+    if (!offset) return words[word];
+    return (words[word] >> offset) | (words[word + 1] << (64 - offset));
+}
+
+// Row pass for packed binary images. The AND over a window of k bits is
+// built from windows of 1, 2, 4... bits, combining the ones that make up k,
+// so a row costs log2(k) word sweeps.
+static void morph_bitRows(void *ctx, int begin, int end) {
+    t_morph_args *args = (t_morph_args *)ctx;
+    int w = args->width;
+    int r = args->radiusX;
+    int k = 2 * r + 1;
+    size_t n = (size_t)w + 2 * r;
+    // Words of the padded row, plus neutral words read past its end
+    size_t used = (n + 63) / 64;
+    size_t total = used + (k + 63) / 64 + 2;
+
+    uint64_t *scratch = (uint64_t *)malloc(total * 2 * sizeof(uint64_t));
+    if (!scratch) {
+        morph_fail(args);
+        return;
+    }
+    uint64_t *span = scratch;          // Windows of the current power of two
+    uint64_t *window = scratch + total; // Windows of the bits of k used so far
+
+    for (int y = begin; y < end; y++) {
+        const uint8_t *src = args->rows[y];
+
+        memset(span, 0xFF, total * sizeof(uint64_t));
+        for (int x = 0; x < w; x++) {
+            uint64_t clear = ((src[x] ^ args->mask) >> 7) ^ 1;
+            span[(x + r) >> 6] &= ~(clear << ((x + r) & 63));
+        }
+
+        int spanLength = 1, windowLength = 0;
+        for (int rest = k; rest; rest >>= 1) {
+            if (rest & 1) {
+                if (!windowLength) {
+                    memcpy(window, span, total * sizeof(uint64_t));
+                } else {
+                    for (size_t i = 0; i < used; i++) window[i] &= morph_bitsAt(span, i * 64 + windowLength);
+                }
+                windowLength += spanLength;
+            }
+            if (rest > 1) {
+                // Ascending order only reads words not yet updated
+                for (size_t i = 0; i < used; i++) span[i] &= morph_bitsAt(span, i * 64 + spanLength);
+                spanLength *= 2;
+            }
+        }
+
+        memcpy(args->bits + (size_t)y * args->bitStride, window, args->bitStride * sizeof(uint64_t));
+    }
+
+    free(scratch);
+}
+
+// Column pass for packed binary images: van Herk / Gil-Werman with AND on
+// whole words, then unpacking to 0 and 255
+static void morph_bitColumns(void *ctx, int begin, int end) {
+    t_morph_args *args = (t_morph_args *)ctx;
+    int h = args->height;
+    int r = args->radiusY;
+    int k = 2 * r + 1;
+    int n = h + 2 * r;
+    const int lanes = MORPH_WORD_BLOCK;
+
+    uint64_t *scratch = (uint64_t *)pool_acquire((size_t)n * 2 * lanes * sizeof(uint64_t));
+    if (!scratch) {
+        morph_fail(args);
+        return;
+    }
+    uint64_t *G = scratch;
+    uint64_t *H = scratch + (size_t)n * lanes;
+
+#define PADDED_WORD(i, v) ((i) >= r && (i) < r + h ? args->bits[(size_t)((i) - r) * args->bitStride + w0 + (v)] : ~(uint64_t)0)
+
+    for (int block = begin; block < end; block++) {
+        int w0 = block * MORPH_WORD_BLOCK;
+        int w1 = w0 + MORPH_WORD_BLOCK < (int)args->bitStride ? w0 + MORPH_WORD_BLOCK : (int)args->bitStride;
+        int count = w1 - w0;
+
+        for (int start = 0; start < n; start += k) {
+            int stop = start + k < n ? start + k : n;
+            for (int i = start; i < stop; i++) {
+                uint64_t *g = G + (size_t)i * lanes;
+                for (int v = 0; v < count; v++) g[v] = i == start ? PADDED_WORD(i, v) : g[v - lanes] & PADDED_WORD(i, v);
+            }
+            for (int i = stop - 1; i >= start; i--) {
+                uint64_t *hw = H + (size_t)i * lanes;
+                for (int v = 0; v < count; v++) hw[v] = i == stop - 1 ? PADDED_WORD(i, v) : hw[v + lanes] & PADDED_WORD(i, v);
+            }
+        }
+
+        int x0 = w0 * 64;
+        int x1 = w1 * 64 < args->width ? w1 * 64 : args->width;
+        for (int y = 0; y < h; y++) {
+            const uint64_t *hw = H + (size_t)y * lanes;
+            const uint64_t *g = G + (size_t)(y + k - 1) * lanes;
+            uint8_t *dst = args->rows[y];
+            for (int x = x0; x < x1; x++) {
+                int v = (x - x0) >> 6;
+                uint64_t word = hw[v] & g[v];
+                dst[x] = (uint8_t)(0 - ((word >> (x & 63)) & 1)) ^ args->mask;
+            }
+        }
+    }
+
+#undef PADDED_WORD
+
+    pool_release(scratch);
+}
+
+// Thresholded images hold only 0 and 255 and can be packed to bits
+static int morph_isBinary(uint8_t **rows, int width, int height, int channels) {
+    if (channels != 1) return 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (rows[y][x] != 0 && rows[y][x] != 0xFF) return 0;
+        }
+    }
+    return 1;
+}
+
+int morph_apply(uint8_t **rows, int width, int height, int channels, int radiusX, int radiusY, t_morph_op op) {
+    if (!rows || width <= 0 || height <= 0 || channels <= 0 || radiusX < 0 || radiusY < 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    t_morph_args args;
+    args.rows = rows;
+    args.width = width;
+    args.height = height;
+    args.channels = channels;
+    args.radiusX = radiusX;
+    args.radiusY = radiusY;
+    args.mask = op == MORPH_DILATE ? 0xFF : 0x00;
+    args.plane = NULL;
+    args.bits = NULL;
+    args.failed = 0;
+
+    if (morph_isBinary(rows, width, height, channels)) {
+        args.bitStride = (width + 63) / 64;
+        args.bits = (uint64_t *)pool_acquire(args.bitStride * height * sizeof(uint64_t));
+        if (!args.bits) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            return 0;
+        }
+
+        scheduler_parallelFor(0, height, scheduler_rowGrain(width / 8 + 1), morph_bitRows, &args);
+        if (!args.failed) {
+            int blocks = (int)((args.bitStride + MORPH_WORD_BLOCK - 1) / MORPH_WORD_BLOCK);
+            scheduler_parallelFor(0, blocks, 1, morph_bitColumns, &args);
+        }
+        pool_release(args.bits);
+    } else {
+        int samples = width * channels;
+        args.planeStride = POOL_ROW_STRIDE((size_t)samples);
+        args.plane = (uint8_t *)pool_acquire(args.planeStride * height);
+        if (!args.plane) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            return 0;
+        }
+
+        scheduler_parallelFor(0, height, scheduler_rowGrain(samples), morph_rows, &args);
+        if (!args.failed) {
+            int blocks = (samples + MORPH_BLOCK - 1) / MORPH_BLOCK;
+            scheduler_parallelFor(0, blocks, 1, morph_columns, &args);
+        }
+        pool_release(args.plane);
+    }
+
+    if (args.failed) fprintf(stderr, "Error: Memory allocation failed\n");
+    return !args.failed;
+}
@@ -0,0 +1,22 @@
+#ifndef MORPH_H
+#define MORPH_H
+
+#include <stdint.h>
+
+typedef enum {
+    MORPH_ERODE,   // Minimum over the structuring element
+    MORPH_DILATE   // Maximum over the structuring element
+} t_morph_op;
+
+// Erosion or dilation with a (2 * radiusX + 1) x (2 * radiusY + 1)
+// rectangle, as a row pass followed by a column pass. Each pass uses the
+// van Herk / Gil-Werman algorithm: prefix and suffix extrema over blocks of
+// the element's length give any window's extremum from two values, so the
+// cost per pixel does not depend on the element size. Pixels outside the
+// image do not take part. Images holding only 0 and 255 with one channel
+// are processed as packed bits, 64 pixels per word.
+// rows[y] points to width pixels of channels interleaved 8-bit samples.
+// Returns 0 on allocation failure.
+int morph_apply(uint8_t **rows, int width, int height, int channels, int radiusX, int radiusY, t_morph_op op);
+
+#endif // MORPH_H
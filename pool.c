@@ -0,0 +1,184 @@
+#include "pool.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+// Bookkeeping stored in front of every buffer, padded so that the buffer
+// itself stays aligned
+#define POOL_HEADER_SIZE POOL_ALIGNMENT
+#define POOL_HUGEPAGE_SIZE ((size_t)2 * 1024 * 1024)
+
+typedef struct t_pool_block {
+    size_t size;
+    struct t_pool_block *next;
+} t_pool_block;
+
+// Idle buffers of one size, most recently used class first
+typedef struct t_pool_class {
+    size_t size;
+    t_pool_block *blocks;
+    struct t_pool_class *next;
+} t_pool_class;
+
+static t_pool_class *pool_classes = NULL;
+static size_t pool_idle = 0;
+static size_t pool_limit = POOL_DEFAULT_LIMIT;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *pool_data(t_pool_block *block) {
+    return (unsigned char *)block + POOL_HEADER_SIZE;
+}
+
+static t_pool_block *pool_block(void *buffer) {
+    return (t_pool_block *)((unsigned char *)buffer - POOL_HEADER_SIZE);
+}
+
+// Finds the class of a size and moves it to the front of the list
+static t_pool_class *pool_findClass(size_t size) {
+    t_pool_class *prev = NULL;
+    for (t_pool_class *cls = pool_classes; cls; prev = cls, cls = cls->next) {
+        if (cls->size == size) {
+            if (prev) {
+                prev->next = cls->next;
+                cls->next = pool_classes;
+                pool_classes = cls;
+            }
+            return cls;
+        }
+    }
+    return NULL;
+}
+
+// Frees idle buffers of the least recently used classes until the idle
+// memory plus extra bytes fits under the limit. Called with the lock held.
+static void pool_trim(size_t extra) {
+    while (pool_classes && pool_idle + extra > pool_limit) {
+        t_pool_class *prev = NULL;
+        t_pool_class *last = pool_classes;
+        while (last->next) {
+            prev = last;
+            last = last->next;
+        }
+
+        t_pool_block *block = last->blocks;
+        if (block) {
+            last->blocks = block->next;
+            pool_idle -= block->size;
+            free(block);
+        }
+        if (!last->blocks) {
+            if (prev) prev->next = NULL;
+            else pool_classes = NULL;
+            free(last);
+        }
+    }
+}
+
+static t_pool_block *pool_allocate(size_t bytes) {
+    void *memory = NULL;
+
+    if (bytes >= POOL_HUGEPAGE_THRESHOLD) {
+        // Start on a huge page boundary so the whole buffer can be promoted
+        size_t rounded = (bytes + POOL_HUGEPAGE_SIZE - 1) / POOL_HUGEPAGE_SIZE * POOL_HUGEPAGE_SIZE;
+        if (posix_memalign(&memory, POOL_HUGEPAGE_SIZE, rounded) != 0) return NULL;
+#ifdef MADV_HUGEPAGE
+        madvise(memory, rounded, MADV_HUGEPAGE);
+#endif
+    } else if (posix_memalign(&memory, POOL_ALIGNMENT, bytes) != 0) {
+        return NULL;
+    }
+    return (t_pool_block *)memory;
+}
+
+void *pool_acquire(size_t size) {
+    if (size == 0) return NULL;
+
+    pthread_mutex_lock(&pool_lock);
+    t_pool_class *cls = pool_findClass(size);
+    if (cls && cls->blocks) {
+        t_pool_block *block = cls->blocks;
+        cls->blocks = block->next;
+        pool_idle -= size;
+        pthread_mutex_unlock(&pool_lock);
+        return pool_data(block);
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    t_pool_block *block = pool_allocate(POOL_HEADER_SIZE + size);
+    if (!block) return NULL;
+    block->size = size;
+    block->next = NULL;
+    return pool_data(block);
+}
+
+void pool_release(void *buffer) {
+    if (!buffer) return;
+
+    t_pool_block *block = pool_block(buffer);
+    pthread_mutex_lock(&pool_lock);
+
+    if (block->size > pool_limit) {
+        pthread_mutex_unlock(&pool_lock);
+        free(block);
+        return;
+    }
+
+    t_pool_class *cls = pool_findClass(block->size);
+    if (!cls) {
+        cls = (t_pool_class *)malloc(sizeof(t_pool_class));
+        if (!cls) {
+            pthread_mutex_unlock(&pool_lock);
+            free(block);
+            return;
+        }
+        cls->size = block->size;
+        cls->blocks = NULL;
+        cls->next = pool_classes;
+        pool_classes = cls;
+    }
+
+    // Make room by evicting other classes, never the one being refilled
+    pool_classes = cls->next;
+    pool_trim(block->size);
+    cls->next = pool_classes;
+    pool_classes = cls;
+
+    if (pool_idle + block->size > pool_limit) {
+        // This size alone already fills the pool
+        if (!cls->blocks) {
+            pool_classes = cls->next;
+            free(cls);
+        }
+        pthread_mutex_unlock(&pool_lock);
+        free(block);
+        return;
+    }
+
+    block->next = cls->blocks;
+    cls->blocks = block;
+    pool_idle += block->size;
+    pthread_mutex_unlock(&pool_lock);
+}
+
+void pool_setLimit(size_t bytes) {
+    pthread_mutex_lock(&pool_lock);
+    pool_limit = bytes;
+    pool_trim(0);
+    pthread_mutex_unlock(&pool_lock);
+}
+
+void pool_clear(void) {
+    pthread_mutex_lock(&pool_lock);
+    while (pool_classes) {
+        t_pool_class *cls = pool_classes;
+        pool_classes = cls->next;
+        while (cls->blocks) {
+            t_pool_block *block = cls->blocks;
+            cls->blocks = block->next;
+            free(block);
+        }
+        free(cls);
+    }
+    pool_idle = 0;
+    pthread_mutex_unlock(&pool_lock);
+}
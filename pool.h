@@ -0,0 +1,34 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+// Pool of pixel buffers grouped by exact size (width x height x depth).
+// Released buffers are kept for the next image of the same size, so a batch
+// of same-sized frames stops allocating and faulting pages after the first
+// image. Buffers come from pool_acquire and go back through pool_release;
+// both are thread-safe. Buffers are POOL_ALIGNMENT-aligned.
+
+// Default amount of idle memory the pool may keep
+#define POOL_DEFAULT_LIMIT ((size_t)256 * 1024 * 1024)
+
+// Every buffer starts on a cache line, which is also the widest vector size
+#define POOL_ALIGNMENT 64
+
+// Buffers from this size up are backed by transparent huge pages where the
+// system supports them, cutting TLB misses on full-image sweeps
+#define POOL_HUGEPAGE_THRESHOLD ((size_t)4 * 1024 * 1024)
+
+// Row length in pixels, padded so that rows of 1- or 3-byte pixels all
+// start on a POOL_ALIGNMENT boundary and can be processed in whole vectors
+#define POOL_ROW_STRIDE(width) (((width) + POOL_ALIGNMENT - 1) / POOL_ALIGNMENT * POOL_ALIGNMENT)
+
+void *pool_acquire(size_t size);
+void pool_release(void *buffer);
+
+// Caps the idle memory kept by the pool; 0 disables caching
+void pool_setLimit(size_t bytes);
+// Frees every idle buffer
+void pool_clear(void);
+
+#endif // POOL_H
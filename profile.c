@@ -0,0 +1,145 @@
+#include "profile.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+static const char *counter_names[PROFILE_COUNTER_COUNT] = {
+    "cycles", "instructions", "L1d misses", "LLC misses", "branch misses"
+};
+
+static int profile_active = 0;
+
+#ifdef __linux__
+static int counter_fds[PROFILE_COUNTER_COUNT] = {-1, -1, -1, -1, -1};
+
+static int open_counter(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // Counters are inherited by threads created after profile_init, so the
+    // worker threads of the filters are counted along with the caller.
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Reads a counter, scaling it up when the kernel had to multiplex it
+static uint64_t read_counter(int fd) {
+    uint64_t values[3];
+    if (fd < 0 || read(fd, values, sizeof(values)) != sizeof(values)) return 0;
+    if (values[2] == 0) return 0;
+    if (values[2] < values[1]) {
+        return (uint64_t)((double)values[0] * values[1] / values[2]);
+    }
+    return values[0];
+}
+#endif
+
+int profile_init(void) {
+    int opened = 0;
+#ifdef __linux__
+    const uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D |
+                                   (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    counter_fds[PROFILE_CYCLES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    counter_fds[PROFILE_INSTRUCTIONS] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    counter_fds[PROFILE_L1D_MISSES] = open_counter(PERF_TYPE_HW_CACHE, l1d_read_miss);
+    counter_fds[PROFILE_LLC_MISSES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    counter_fds[PROFILE_BRANCH_MISSES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+
+    for (int i = 0; i < PROFILE_COUNTER_COUNT; i++) {
+        if (counter_fds[i] >= 0) {
+            opened++;
+        }
+    }
+    if (opened < PROFILE_COUNTER_COUNT) {
+        fprintf(stderr, "Warning: only %d of %d hardware counters available "
+                        "(check /proc/sys/kernel/perf_event_paranoid)\n", opened, PROFILE_COUNTER_COUNT);
+    }
+#else
+    fprintf(stderr, "Warning: hardware counters are only supported on Linux, reporting wall time only\n");
+#endif
+    profile_active = 1;
+    return opened;
+}
+
+void profile_shutdown(void) {
+#ifdef __linux__
+    for (int i = 0; i < PROFILE_COUNTER_COUNT; i++) {
+        if (counter_fds[i] >= 0) {
+            close(counter_fds[i]);
+            counter_fds[i] = -1;
+        }
+    }
+#endif
+    profile_active = 0;
+}
+
+int profile_enabled(void) {
+    return profile_active;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void profile_begin(t_profile *prof) {
+    if (!prof) return;
+    memset(prof, 0, sizeof(*prof));
+    if (!profile_active) return;
+
+#ifdef __linux__
+    for (int i = 0; i < PROFILE_COUNTER_COUNT; i++) {
+        prof->counters[i] = read_counter(counter_fds[i]);
+    }
+#endif
+    prof->seconds = now_seconds();
+}
+
+void profile_end(t_profile *prof, const char *name, uint64_t pixels) {
+    if (!prof || !profile_active) return;
+
+    double seconds = now_seconds() - prof->seconds;
+    double megapixels = pixels / 1e6;
+    uint64_t delta[PROFILE_COUNTER_COUNT] = {0};
+    int available[PROFILE_COUNTER_COUNT] = {0};
+
+#ifdef __linux__
+    for (int i = 0; i < PROFILE_COUNTER_COUNT; i++) {
+        if (counter_fds[i] >= 0) {
+            delta[i] = read_counter(counter_fds[i]) - prof->counters[i];
+            available[i] = 1;
+        }
+    }
+#endif
+
+    printf("Profile: %s (%.2f MP)\n", name ? name : "operation", megapixels);
+    printf("  %-14s %14.3f ms", "wall time", seconds * 1e3);
+    if (megapixels > 0) printf("  %12.3f ms/MP", seconds * 1e3 / megapixels);
+    printf("\n");
+
+    for (int i = 0; i < PROFILE_COUNTER_COUNT; i++) {
+        if (!available[i]) continue;
+        printf("  %-14s %14llu", counter_names[i], (unsigned long long)delta[i]);
+        if (megapixels > 0) printf("  %12.0f /MP", delta[i] / megapixels);
+        printf("\n");
+    }
+
+    if (available[PROFILE_CYCLES] && available[PROFILE_INSTRUCTIONS] && delta[PROFILE_CYCLES] > 0) {
+        printf("  %-14s %14.3f\n", "IPC", (double)delta[PROFILE_INSTRUCTIONS] / delta[PROFILE_CYCLES]);
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+// Hardware counters tracked for each profiled operation
+typedef enum {
+    PROFILE_CYCLES,
+    PROFILE_INSTRUCTIONS,
+    PROFILE_L1D_MISSES,
+    PROFILE_LLC_MISSES,
+    PROFILE_BRANCH_MISSES,
+    PROFILE_COUNTER_COUNT
+} t_profile_counter;
+
+// Snapshot taken by profile_begin and consumed by profile_end
+typedef struct {
+    uint64_t counters[PROFILE_COUNTER_COUNT];
+    double seconds;
+} t_profile;
+
+// Opens the counters (Linux perf_event_open). Returns the number of
+// counters that could be opened; wall time is always reported.
+int profile_init(void);
+void profile_shutdown(void);
+int profile_enabled(void);
+
+// Wrap a filter call: profile_end prints the counter deltas for the
+// operation, IPC, and the same figures per megapixel.
+void profile_begin(t_profile *prof);
+void profile_end(t_profile *prof, const char *name, uint64_t pixels);
+
+#endif // PROFILE_H
@@ -0,0 +1,221 @@
+#include "pyramid.h"
+#include "pool.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    uint8_t **rows;
+    int width;
+    int height;
+    int gaussian;
+    t_pyramid *pyramid;
+    int bandHeight;     // Source rows per band, whole blocks of the last level
+    int failed;
+} t_pyramid_args;
+
+// Progress of one band through every level
+typedef struct {
+    const t_pyramid_args *args;
+    int next[PYRAMID_MAX_LEVELS];   // Next row to reduce
+    int end[PYRAMID_MAX_LEVELS];
+    uint16_t *sums;                 // Vertically filtered row, for the Gaussian
+} t_pyramid_stream;
+
+static int pyramid_min(int a, int b) {
+    return a < b ? a : b;
+}
+
+// Size and rows of the image that level is reduced from
+static int pyramid_parentWidth(const t_pyramid_args *args, int level) {
+    return level ? args->pyramid->levels[level - 1].width : args->width;
+}
+
+static int pyramid_parentHeight(const t_pyramid_args *args, int level) {
+    return level ? args->pyramid->levels[level - 1].height : args->height;
+}
+
+static const uint8_t *pyramid_parentRow(const t_pyramid_args *args, int level, int y) {
+    if (!level) return args->rows[y];
+    const t_pyramid_level *parent = &args->pyramid->levels[level - 1];
+    return parent->data + (size_t)y * parent->stride;
+}
+
+static uint8_t *pyramid_row(const t_pyramid_args *args, int level, int y) {
+    const t_pyramid_level *current = &args->pyramid->levels[level];
+    return current->data + (size_t)y * current->stride;
+}
+
+// Last parent row that row y of level depends on
+static int pyramid_lastNeeded(const t_pyramid_args *args, int level, int y) {
+    return pyramid_min(2 * y + (args->gaussian ? 2 : 1), pyramid_parentHeight(args, level) - 1);
+}
+
+static void pyramid_reduceBox(const t_pyramid_args *args, int level, int y) {
+    int ch = args->pyramid->channels;
+    int parentWidth = pyramid_parentWidth(args, level);
+    int lastRow = pyramid_parentHeight(args, level) - 1;
+    const uint8_t *a = pyramid_parentRow(args, level, 2 * y);
+    const uint8_t *b = pyramid_parentRow(args, level, pyramid_min(2 * y + 1, lastRow));
+    uint8_t *out = pyramid_row(args, level, y);
+
+    int pairs = parentWidth / 2;
+    for (int x = 0; x < pairs; x++) {
+        for (int c = 0; c < ch; c++) {
+            int left = 2 * x * ch + c;
+            int right = left + ch;
+            out[x * ch + c] = (uint8_t)((a[left] + a[right] + b[left] + b[right] + 2) >> 2);
+        }
+    }
+    // An odd last column is paired with itself
+    if (parentWidth & 1) {
+        for (int c = 0; c < ch; c++) {
+            int last = (parentWidth - 1) * ch + c;
+            out[pairs * ch + c] = (uint8_t)((a[last] + b[last] + 1) >> 1);
+        }
+    }
+}
+
+static void pyramid_reduceGaussian(const t_pyramid_stream *stream, int level, int y) {
+    const t_pyramid_args *args = stream->args;
+    int ch = args->pyramid->channels;
+    int parentWidth = pyramid_parentWidth(args, level);
+    int lastRow = pyramid_parentHeight(args, level) - 1;
+    const uint8_t *p0 = pyramid_parentRow(args, level, 2 * y > 0 ? 2 * y - 1 : 0);
+    const uint8_t *p1 = pyramid_parentRow(args, level, 2 * y);
+    const uint8_t *p2 = pyramid_parentRow(args, level, pyramid_min(2 * y + 1, lastRow));
+    const uint8_t *p3 = pyramid_parentRow(args, level, pyramid_min(2 * y + 2, lastRow));
+    uint16_t *sums = stream->sums;
+    uint8_t *out = pyramid_row(args, level, y);
+
+    for (int i = 0; i < parentWidth * ch; i++) {
+        sums[i] = (uint16_t)(p0[i] + 3 * (p1[i] + p2[i]) + p3[i]);
+    }
+
+    int width = args->pyramid->levels[level].width;
+    for (int x = 0; x < width; x++) {
+        // Columns 2x - 1 to 2x + 2, clamped to the row
+        int x0 = 2 * x > 0 ? 2 * x - 1 : 0;
+        int x2 = pyramid_min(2 * x + 1, parentWidth - 1);
+        int x3 = pyramid_min(2 * x + 2, parentWidth - 1);
+        for (int c = 0; c < ch; c++) {
+            int value = sums[x0 * ch + c] + 3 * (sums[2 * x * ch + c] + sums[x2 * ch + c]) + sums[x3 * ch + c];
+            out[x * ch + c] = (uint8_t)((value + 32) >> 6);
+        }
+    }
+}
+
+// Called once row y of the image below level exists: reduces every row of
+// level that now has all its inputs, and passes each one further down
+static void pyramid_advance(t_pyramid_stream *stream, int level, int y) {
+    const t_pyramid_args *args = stream->args;
+    if (level >= args->pyramid->count) return;
+
+    while (stream->next[level] < stream->end[level] && pyramid_lastNeeded(args, level, stream->next[level]) <= y) {
+        int row = stream->next[level]++;
+        if (args->gaussian) {
+            pyramid_reduceGaussian(stream, level, row);
+        } else {
+            pyramid_reduceBox(args, level, row);
+        }
+        pyramid_advance(stream, level + 1, row);
+    }
+}
+
+static void pyramid_bands(void *ctx, int begin, int end) {
+    t_pyramid_args *args = (t_pyramid_args *)ctx;
+    t_pyramid *pyramid = args->pyramid;
+    t_pyramid_stream stream;
+    stream.args = args;
+    stream.sums = NULL;
+    if (args->gaussian) {
+        stream.sums = (uint16_t *)malloc((size_t)args->width * pyramid->channels * sizeof(uint16_t));
+        if (!stream.sums) {
+            __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+
+    for (int band = begin; band < end; band++) {
+        int y0 = band * args->bandHeight;
+        int y1 = pyramid_min(y0 + args->bandHeight, args->height);
+        for (int level = 0; level < pyramid->count; level++) {
+            stream.next[level] = y0 >> (level + 1);
+            stream.end[level] = y1 == args->height ? pyramid->levels[level].height : y1 >> (level + 1);
+        }
+
+        for (int y = y0; y < y1; y++) pyramid_advance(&stream, 0, y);
+    }
+
+    free(stream.sums);
+}
+
+t_pyramid *pyramid_build(uint8_t **rows, int width, int height, int channels, int levels, int gaussian) {
+    if (!rows || width <= 0 || height <= 0 || channels <= 0 || levels < 1) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return NULL;
+    }
+
+    t_pyramid *pyramid = (t_pyramid *)malloc(sizeof(t_pyramid));
+    if (!pyramid) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    pyramid->channels = channels;
+    pyramid->count = 0;
+    size_t total = 0;
+    int levelWidth = width, levelHeight = height;
+    while (pyramid->count < levels && pyramid->count < PYRAMID_MAX_LEVELS && (levelWidth > 1 || levelHeight > 1)) {
+        t_pyramid_level *level = &pyramid->levels[pyramid->count++];
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+        level->width = levelWidth;
+        level->height = levelHeight;
+        level->stride = POOL_ROW_STRIDE((size_t)levelWidth) * channels;
+        total += level->stride * levelHeight;
+    }
+    if (!pyramid->count) {
+        fprintf(stderr, "Error: Image is too small to reduce\n");
+        free(pyramid);
+        return NULL;
+    }
+
+    pyramid->block = pool_acquire(total);
+    if (!pyramid->block) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(pyramid);
+        return NULL;
+    }
+    uint8_t *data = (uint8_t *)pyramid->block;
+    for (int i = 0; i < pyramid->count; i++) {
+        pyramid->levels[i].data = data;
+        data += pyramid->levels[i].stride * pyramid->levels[i].height;
+    }
+
+    t_pyramid_args args = {rows, width, height, gaussian, pyramid, height, 0};
+    if (!gaussian) {
+        // Bands hold whole blocks of the smallest level, so that no level
+        // row needs rows of another band
+        long long block = 1LL << pyramid->count;
+        int bands = scheduler_threadCount() * 4;
+        long long bandHeight = ((height + bands - 1) / bands + block - 1) / block * block;
+        if (bandHeight < height) args.bandHeight = (int)bandHeight;
+    }
+    int bands = (height + args.bandHeight - 1) / args.bandHeight;
+    scheduler_parallelFor(0, bands, 1, pyramid_bands, &args);
+
+    if (args.failed) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        pyramid_free(pyramid);
+        return NULL;
+    }
+    return pyramid;
+}
+
+void pyramid_free(t_pyramid *pyramid) {
+    if (pyramid) {
+        pool_release(pyramid->block);
+        free(pyramid);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Enough halvings to bring any 32-bit side down to one pixel
+#define PYRAMID_MAX_LEVELS 31
+
+typedef struct {
+    int width;
+    int height;
+    size_t stride;    // Bytes between rows, a multiple of 64
+    uint8_t *data;
+} t_pyramid_level;
+
+// Successive halvings of an image: level 0 is half the source size
+// (rounded up), level 1 a quarter, and so on. All levels share one block.
+typedef struct {
+    int count;
+    int channels;
+    t_pyramid_level levels[PYRAMID_MAX_LEVELS];
+    void *block;
+} t_pyramid;
+
+// Builds up to levels halvings of rows (width x height pixels of channels
+// interleaved 8-bit samples), stopping early at 1x1, in a single pass over
+// the source: each finished pair of rows of a level is reduced into the
+// next level right away, while it is still in cache. Levels average 2x2
+// blocks, or with gaussian use the separable [1 3 3 1] / 8 filter over
+// 4x4 pixels, which aliases less. Box pyramids are built in bands of rows
+// in parallel; Gaussian ones read across any band boundary and are built
+// as one stream.
+// Returns NULL on failure.
+t_pyramid *pyramid_build(uint8_t **rows, int width, int height, int channels, int levels, int gaussian);
+void pyramid_free(t_pyramid *pyramid);
+
+#endif // PYRAMID_H
@@ -0,0 +1,276 @@
+#include "quantize.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define QUANTIZE_BITS 5
+#define QUANTIZE_SIDE (1 << QUANTIZE_BITS)
+#define QUANTIZE_CELLS (QUANTIZE_SIDE * QUANTIZE_SIDE * QUANTIZE_SIDE)
+// Pixels sampled for the histogram, so that large images cost no more
+#define QUANTIZE_SAMPLES (1 << 20)
+
+// Histogram cell of colors sharing their top 5 bits; the sums give the
+// mean color of the cell
+typedef struct {
+    uint32_t count;
+    uint32_t sum[3];
+} t_quantize_cell;
+
+// Median-cut box of cells, inclusive bounds per channel
+typedef struct {
+    int lo[3];
+    int hi[3];
+    uint64_t count;
+} t_quantize_box;
+
+typedef struct {
+    uint8_t **rows;
+    int width;
+    int height;
+    int rowStep;            // Sampled rows are rowStep apart
+    int bandRows;           // Sampled rows per band
+    t_quantize_cell *cells;
+    int failed;
+} t_quantize_histogramArgs;
+
+typedef struct {
+    uint8_t **rows;
+    int width;
+    const uint8_t (*palette)[3];
+    int count;
+    uint8_t **indexes;
+    uint8_t inverse[QUANTIZE_CELLS];
+} t_quantize_mapArgs;
+
+static int quantize_cell(int r, int g, int b) {
+    return (r << (2 * QUANTIZE_BITS)) | (g << QUANTIZE_BITS) | b;
+}
+
+static int quantize_cellOf(const uint8_t *pixel) {
+    int shift = 8 - QUANTIZE_BITS;
+    return quantize_cell(pixel[0] >> shift, pixel[1] >> shift, pixel[2] >> shift);
+}
+
+// Each band fills its own histogram, then adds it to the shared one
+static void quantize_histogramBands(void *ctx, int begin, int end) {
+    t_quantize_histogramArgs *args = (t_quantize_histogramArgs *)ctx;
+    t_quantize_cell *local = (t_quantize_cell *)calloc(QUANTIZE_CELLS, sizeof(t_quantize_cell));
+    if (!local) {
+        __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    int first = begin * args->bandRows;
+    int last = end * args->bandRows;
+    for (int i = first; i < last && (long long)i * args->rowStep < args->height; i++) {
+        const uint8_t *pixel = args->rows[(size_t)i * args->rowStep];
+        for (int x = 0; x < args->width; x++, pixel += 3) {
+            t_quantize_cell *cell = &local[quantize_cellOf(pixel)];
+            cell->count++;
+            cell->sum[0] += pixel[0];
+            cell->sum[1] += pixel[1];
+            cell->sum[2] += pixel[2];
+        }
+    }
+
+    for (int i = 0; i < QUANTIZE_CELLS; i++) {
+        if (!local[i].count) continue;
+        __atomic_fetch_add(&args->cells[i].count, local[i].count, __ATOMIC_RELAXED);
+        for (int c = 0; c < 3; c++) __atomic_fetch_add(&args->cells[i].sum[c], local[i].sum[c], __ATOMIC_RELAXED);
+    }
+    free(local);
+}
+
+// Tightens the box around its populated cells and counts its pixels
+static void quantize_shrink(const t_quantize_cell *cells, t_quantize_box *box) {
+    int lo[3] = {QUANTIZE_SIDE, QUANTIZE_SIDE, QUANTIZE_SIDE};
+    int hi[3] = {-1, -1, -1};
+    box->count = 0;
+
+    for (int r = box->lo[0]; r <= box->hi[0]; r++) {
+        for (int g = box->lo[1]; g <= box->hi[1]; g++) {
+            for (int b = box->lo[2]; b <= box->hi[2]; b++) {
+                uint32_t count = cells[quantize_cell(r, g, b)].count;
+                if (!count) continue;
+                int at[3] = {r, g, b};
+                for (int c = 0; c < 3; c++) {
+                    if (at[c] < lo[c]) lo[c] = at[c];
+                    if (at[c] > hi[c]) hi[c] = at[c];
+                }
+                box->count += count;
+            }
+        }
+    }
+
+    if (box->count) {
+        memcpy(box->lo, lo, sizeof(lo));
+        memcpy(box->hi, hi, sizeof(hi));
+    }
+}
+
+static int quantize_longestAxis(const t_quantize_box *box) {
+    int axis = 0;
+    for (int c = 1; c < 3; c++) {
+        if (box->hi[c] - box->lo[c] > box->hi[axis] - box->lo[axis]) axis = c;
+    }
+    return axis;
+}
+
+// Splits box at the median of its longest side, each half keeping at
+// least one slice
+static void quantize_split(const t_quantize_cell *cells, t_quantize_box *box, t_quantize_box *other) {
+    int axis = quantize_longestAxis(box);
+    uint64_t slices[QUANTIZE_SIDE] = {0};
+
+    for (int r = box->lo[0]; r <= box->hi[0]; r++) {
+        for (int g = box->lo[1]; g <= box->hi[1]; g++) {
+            for (int b = box->lo[2]; b <= box->hi[2]; b++) {
+                int at[3] = {r, g, b};
+                slices[at[axis]] += cells[quantize_cell(r, g, b)].count;
+            }
+        }
+    }
+
+    int cut = box->lo[axis];
+    uint64_t below = slices[cut];
+    while (cut + 1 < box->hi[axis] && below * 2 < box->count) below += slices[++cut];
+
+    *other = *box;
+    box->hi[axis] = cut;
+    other->lo[axis] = cut + 1;
+    quantize_shrink(cells, box);
+    quantize_shrink(cells, other);
+}
+
+int quantize_palette(uint8_t **rows, int width, int height, int ncolors, uint8_t palette[][3]) {
+    if (!rows || !palette || width <= 0 || height <= 0 || ncolors < 1 || ncolors > QUANTIZE_MAX_COLORS) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    t_quantize_histogramArgs args = {rows, width, height, 1, 1, NULL, 0};
+    args.cells = (t_quantize_cell *)calloc(QUANTIZE_CELLS, sizeof(t_quantize_cell));
+    t_quantize_box *boxes = (t_quantize_box *)malloc(ncolors * sizeof(t_quantize_box));
+    if (!args.cells || !boxes) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(args.cells);
+        free(boxes);
+        return 0;
+    }
+
+    // Whole rows are sampled, spread evenly down the image
+    long long pixels = (long long)width * height;
+    if (pixels > QUANTIZE_SAMPLES) args.rowStep = (int)((pixels + QUANTIZE_SAMPLES - 1) / QUANTIZE_SAMPLES);
+    int sampledRows = (height + args.rowStep - 1) / args.rowStep;
+    int bands = scheduler_threadCount() * 4;
+    args.bandRows = (sampledRows + bands - 1) / bands;
+    bands = (sampledRows + args.bandRows - 1) / args.bandRows;
+    scheduler_parallelFor(0, bands, 1, quantize_histogramBands, &args);
+    if (args.failed) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(args.cells);
+        free(boxes);
+        return 0;
+    }
+
+    int count = 1;
+    boxes[0] = (t_quantize_box){{0, 0, 0}, {QUANTIZE_SIDE - 1, QUANTIZE_SIDE - 1, QUANTIZE_SIDE - 1}, 0};
+    quantize_shrink(args.cells, &boxes[0]);
+    while (count < ncolors) {
+        int best = -1;
+        uint64_t bestScore = 0;
+        for (int i = 0; i < count; i++) {
+            int axis = quantize_longestAxis(&boxes[i]);
+            uint64_t score = boxes[i].count * (uint64_t)(boxes[i].hi[axis] - boxes[i].lo[axis]);
+            if (score > bestScore) {
+                best = i;
+                bestScore = score;
+            }
+        }
+        // Every box is a single cell
+        if (best < 0) break;
+        quantize_split(args.cells, &boxes[best], &boxes[count++]);
+    }
+
+    for (int i = 0; i < count; i++) {
+        uint64_t sum[3] = {0, 0, 0};
+        const t_quantize_box *box = &boxes[i];
+        for (int r = box->lo[0]; r <= box->hi[0]; r++) {
+            for (int g = box->lo[1]; g <= box->hi[1]; g++) {
+                for (int b = box->lo[2]; b <= box->hi[2]; b++) {
+                    const t_quantize_cell *cell = &args.cells[quantize_cell(r, g, b)];
+                    for (int c = 0; c < 3; c++) sum[c] += cell->sum[c];
+                }
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            palette[i][c] = box->count ? (uint8_t)((sum[c] + box->count / 2) / box->count) : 0;
+        }
+    }
+
+    free(args.cells);
+    free(boxes);
+    return count;
+}
+
+// Nearest palette color of each cell center, a red slice per step
+static void quantize_inverseSlices(void *ctx, int begin, int end) {
+    t_quantize_mapArgs *args = (t_quantize_mapArgs *)ctx;
+    int shift = 8 - QUANTIZE_BITS;
+    int half = 1 << (shift - 1);
+
+    for (int r = begin; r < end; r++) {
+        for (int g = 0; g < QUANTIZE_SIDE; g++) {
+            for (int b = 0; b < QUANTIZE_SIDE; b++) {
+                int center[3] = {(r << shift) + half, (g << shift) + half, (b << shift) + half};
+                int best = 0, bestDistance = 1 << 30;
+                for (int i = 0; i < args->count; i++) {
+                    int dr = center[0] - args->palette[i][0];
+                    int dg = center[1] - args->palette[i][1];
+                    int db = center[2] - args->palette[i][2];
+                    int distance = dr * dr + dg * dg + db * db;
+                    if (distance < bestDistance) {
+                        best = i;
+                        bestDistance = distance;
+                    }
+                }
+                args->inverse[quantize_cell(r, g, b)] = (uint8_t)best;
+            }
+        }
+    }
+}
+
+static void quantize_mapRows(void *ctx, int begin, int end) {
+    const t_quantize_mapArgs *args = (const t_quantize_mapArgs *)ctx;
+
+    for (int y = begin; y < end; y++) {
+        const uint8_t *pixel = args->rows[y];
+        uint8_t *index = args->indexes[y];
+        for (int x = 0; x < args->width; x++, pixel += 3) index[x] = args->inverse[quantize_cellOf(pixel)];
+    }
+}
+
+int quantize_map(uint8_t **rows, int width, int height, const uint8_t palette[][3], int count,
+                 uint8_t **indexes) {
+    if (!rows || !palette || !indexes || width <= 0 || height <= 0 || count < 1 || count > QUANTIZE_MAX_COLORS) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    t_quantize_mapArgs *args = (t_quantize_mapArgs *)malloc(sizeof(t_quantize_mapArgs));
+    if (!args) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 0;
+    }
+    args->rows = rows;
+    args->width = width;
+    args->palette = palette;
+    args->count = count;
+    args->indexes = indexes;
+
+    scheduler_parallelFor(0, QUANTIZE_SIDE, 1, quantize_inverseSlices, args);
+    scheduler_parallelFor(0, height, scheduler_rowGrain(width), quantize_mapRows, args);
+    free(args);
+    return 1;
+}
@@ -0,0 +1,22 @@
+#ifndef QUANTIZE_H
+#define QUANTIZE_H
+
+#include <stdint.h>
+
+#define QUANTIZE_MAX_COLORS 256
+
+// Median-cut palette of at most ncolors colors for interleaved red, green,
+// blue rows. Colors are counted in a 32x32x32 histogram of the top 5 bits,
+// built in parallel from a sample of at most about a million pixels. The
+// box with the most pixels times its longest side is split at its median
+// until there are ncolors boxes, and each palette entry is the mean of the
+// pixels in its box. Returns the number of colors, 0 on error.
+int quantize_palette(uint8_t **rows, int width, int height, int ncolors, uint8_t palette[][3]);
+
+// Index of the nearest palette color for every pixel, through a 32K-entry
+// table holding the nearest color of each histogram cell. Rows are mapped
+// in parallel. Returns 0 on error.
+int quantize_map(uint8_t **rows, int width, int height, const uint8_t palette[][3], int count,
+                 uint8_t **indexes);
+
+#endif // QUANTIZE_H
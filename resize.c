@@ -0,0 +1,297 @@
+#include "resize.h"
+#include "pool.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Weights are fixed point with this many fractional bits
+#define RESIZE_PRECISION 14
+#define RESIZE_ONE (1 << RESIZE_PRECISION)
+
+// Samples accumulated at a time by the vertical pass, to stay in L1
+#define RESIZE_CHUNK 1024
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Every output sample reads taps consecutive source samples from first
+typedef struct {
+    int *first;
+    int16_t *weights;   // taps per output sample
+    int taps;
+} t_resize_coefficients;
+
+typedef struct {
+    uint8_t **src;
+    uint8_t **dst;
+    int srcWidth;
+    int dstWidth;
+    int channels;
+    const t_resize_coefficients *columns;
+    const t_resize_coefficients *lines;
+    uint8_t *temp;          // Horizontally resized source rows
+    size_t tempStride;
+    int firstRow;           // Source row of the first temp row
+    int factorX;            // Block size of the integer-factor path
+    int factorY;
+    int failed;
+} t_resize_args;
+
+static double resize_sinc(double x) {
+    if (x == 0) return 1;
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+static double resize_weight(t_resize_filter filter, double x) {
+    switch (filter) {
+        case RESIZE_BOX:
+            return x >= -0.5 && x < 0.5 ? 1 : 0;
+        case RESIZE_BILINEAR:
+            x = fabs(x);
+            return x < 1 ? 1 - x : 0;
+        default:
+            return fabs(x) < 3 ? resize_sinc(x) * resize_sinc(x / 3) : 0;
+    }
+}
+
+static double resize_support(t_resize_filter filter) {
+    switch (filter) {
+        case RESIZE_BOX:
+            return 0.5;
+        case RESIZE_BILINEAR:
+            return 1;
+        default:
+            return 3;
+    }
+}
+
+static void resize_freeCoefficients(t_resize_coefficients *coefficients) {
+    free(coefficients->first);
+    free(coefficients->weights);
+}
+
+// Weights of every output sample, normalized so each set sums to exactly
+// RESIZE_ONE; sets are padded with zero weights to the same tap count
+static int resize_coefficients(t_resize_coefficients *coefficients, int srcSize, int dstSize,
+                               t_resize_filter filter) {
+    double scale = (double)srcSize / dstSize;
+    double filterScale = scale > 1 ? scale : 1;
+    double support = resize_support(filter) * filterScale;
+    int taps = (int)ceil(support) * 2 + 1;
+    if (taps > srcSize) taps = srcSize;
+
+    coefficients->taps = taps;
+    coefficients->first = (int *)malloc(dstSize * sizeof(int));
+    coefficients->weights = (int16_t *)calloc((size_t)dstSize * taps, sizeof(int16_t));
+    double *weights = (double *)malloc(taps * sizeof(double));
+    if (!coefficients->first || !coefficients->weights || !weights) {
+        resize_freeCoefficients(coefficients);
+        free(weights);
+        return 0;
+    }
+
+    for (int i = 0; i < dstSize; i++) {
+        double center = (i + 0.5) * scale;
+        int low = (int)floor(center - support + 0.5);
+        int high = (int)floor(center + support + 0.5);
+        if (low < 0) low = 0;
+        if (high > srcSize) high = srcSize;
+        if (high - low > taps) high = low + taps;
+
+        // Keep the taps inside the source; the ones moved over get no weight
+        int first = low + taps > srcSize ? srcSize - taps : low;
+        double total = 0;
+        for (int k = 0; k < taps; k++) {
+            int j = first + k;
+            weights[k] = j >= low && j < high ? resize_weight(filter, (j + 0.5 - center) / filterScale) : 0;
+            total += weights[k];
+        }
+        // A box narrower than the spacing may miss every center; fall back
+        // to the nearest sample
+        if (total == 0) {
+            int nearest = (int)center;
+            if (nearest >= srcSize) nearest = srcSize - 1;
+            weights[nearest - first] = total = 1;
+        }
+
+        int16_t *fixed = coefficients->weights + (size_t)i * taps;
+        int sum = 0, largest = 0;
+        for (int k = 0; k < taps; k++) {
+            fixed[k] = (int16_t)lround(weights[k] / total * RESIZE_ONE);
+            sum += fixed[k];
+            if (fixed[k] > fixed[largest]) largest = k;
+        }
+        fixed[largest] += RESIZE_ONE - sum;
+        coefficients->first[i] = first;
+    }
+
+    free(weights);
+    return 1;
+}
+
+static uint8_t resize_clamp(int32_t value) {
+    value = (value + RESIZE_ONE / 2) >> RESIZE_PRECISION;
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// Inlined with a constant channel count for the common depths. Scalar:
+// every output sample reads its own taps
+static inline void resize_horizontalRow(const t_resize_args *args, const uint8_t *src, uint8_t *dst, int ch) {
+    const t_resize_coefficients *columns = args->columns;
+    int taps = columns->taps;
+
+    for (int x = 0; x < args->dstWidth; x++) {
+        const int16_t *weights = columns->weights + (size_t)x * taps;
+        const uint8_t *in = src + (size_t)columns->first[x] * ch;
+        int32_t sums[4] = {0, 0, 0, 0};
+        for (int k = 0; k < taps; k++) {
+            for (int c = 0; c < ch; c++) sums[c] += weights[k] * in[k * ch + c];
+        }
+        for (int c = 0; c < ch; c++) dst[x * ch + c] = resize_clamp(sums[c]);
+    }
+}
+
+static void resize_horizontal(void *ctx, int begin, int end) {
+    t_resize_args *args = (t_resize_args *)ctx;
+
+    for (int y = begin; y < end; y++) {
+        const uint8_t *src = args->src[y];
+        uint8_t *dst = args->temp + (size_t)(y - args->firstRow) * args->tempStride;
+        switch (args->channels) {
+            case 1:
+                resize_horizontalRow(args, src, dst, 1);
+                break;
+            case 3:
+                resize_horizontalRow(args, src, dst, 3);
+                break;
+            default:
+                resize_horizontalRow(args, src, dst, args->channels);
+                break;
+        }
+    }
+}
+
+// Output rows are weighted sums of whole temp rows: a contiguous 16x8-bit
+// multiply-accumulate into 32-bit sums, which GCC vectorizes at -O3 (at
+// -O2 its cost model leaves it scalar)
+static void resize_vertical(void *ctx, int begin, int end) {
+    t_resize_args *args = (t_resize_args *)ctx;
+    const t_resize_coefficients *lines = args->lines;
+    int samples = args->dstWidth * args->channels;
+    int32_t sums[RESIZE_CHUNK];
+
+    for (int y = begin; y < end; y++) {
+        const int16_t *weights = lines->weights + (size_t)y * lines->taps;
+        const uint8_t *first = args->temp + (size_t)(lines->first[y] - args->firstRow) * args->tempStride;
+        uint8_t *dst = args->dst[y];
+
+        for (int start = 0; start < samples; start += RESIZE_CHUNK) {
+            int count = samples - start < RESIZE_CHUNK ? samples - start : RESIZE_CHUNK;
+            memset(sums, 0, count * sizeof(int32_t));
+            for (int k = 0; k < lines->taps; k++) {
+                int32_t weight = weights[k];
+                if (!weight) continue;
+                const uint8_t *in = first + (size_t)k * args->tempStride + start;
+                for (int i = 0; i < count; i++) sums[i] += weight * in[i];
+            }
+            for (int i = 0; i < count; i++) dst[start + i] = resize_clamp(sums[i]);
+        }
+    }
+}
+
+// Integer-factor box shrinking: each output sample is the mean of a block
+static void resize_blocks(void *ctx, int begin, int end) {
+    t_resize_args *args = (t_resize_args *)ctx;
+    int ch = args->channels;
+    int fx = args->factorX;
+    int fy = args->factorY;
+    int samples = args->dstWidth * ch;
+    uint32_t area = (uint32_t)fx * fy;
+    uint32_t *sums = (uint32_t *)malloc(samples * sizeof(uint32_t));
+    if (!sums) {
+        __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    for (int y = begin; y < end; y++) {
+        memset(sums, 0, samples * sizeof(uint32_t));
+        for (int j = 0; j < fy; j++) {
+            const uint8_t *src = args->src[y * fy + j];
+            for (int x = 0; x < args->dstWidth; x++) {
+                const uint8_t *in = src + (size_t)x * fx * ch;
+                uint32_t *sum = sums + x * ch;
+                for (int k = 0; k < fx; k++) {
+                    for (int c = 0; c < ch; c++) sum[c] += in[k * ch + c];
+                }
+            }
+        }
+
+        uint8_t *dst = args->dst[y];
+        for (int i = 0; i < samples; i++) dst[i] = (uint8_t)((sums[i] + area / 2) / area);
+    }
+
+    free(sums);
+}
+
+int resize_image(uint8_t **src, int srcWidth, int srcHeight, uint8_t **dst, int dstWidth, int dstHeight,
+                 int channels, t_resize_filter filter) {
+    if (!src || !dst || srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0 || channels <= 0 ||
+        channels > 4) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    t_resize_args args;
+    memset(&args, 0, sizeof(args));
+    args.src = src;
+    args.dst = dst;
+    args.srcWidth = srcWidth;
+    args.dstWidth = dstWidth;
+    args.channels = channels;
+
+    if (filter == RESIZE_BOX && srcWidth % dstWidth == 0 && srcHeight % dstHeight == 0) {
+        args.factorX = srcWidth / dstWidth;
+        args.factorY = srcHeight / dstHeight;
+        scheduler_parallelFor(0, dstHeight, scheduler_rowGrain(srcWidth * args.factorY), resize_blocks, &args);
+        if (args.failed) fprintf(stderr, "Error: Memory allocation failed\n");
+        return !args.failed;
+    }
+
+    t_resize_coefficients columns, lines;
+    if (!resize_coefficients(&columns, srcWidth, dstWidth, filter)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 0;
+    }
+    if (!resize_coefficients(&lines, srcHeight, dstHeight, filter)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        resize_freeCoefficients(&columns);
+        return 0;
+    }
+    args.columns = &columns;
+    args.lines = &lines;
+
+    // Only the source rows some output row reads are resized horizontally
+    args.firstRow = lines.first[0];
+    int lastRow = lines.first[dstHeight - 1] + lines.taps;
+    args.tempStride = POOL_ROW_STRIDE((size_t)dstWidth * channels);
+    args.temp = (uint8_t *)pool_acquire(args.tempStride * (lastRow - args.firstRow));
+    if (!args.temp) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        resize_freeCoefficients(&columns);
+        resize_freeCoefficients(&lines);
+        return 0;
+    }
+
+    scheduler_parallelFor(args.firstRow, lastRow, scheduler_rowGrain(dstWidth * columns.taps), resize_horizontal,
+                          &args);
+    scheduler_parallelFor(0, dstHeight, scheduler_rowGrain(dstWidth * lines.taps), resize_vertical, &args);
+
+    pool_release(args.temp);
+    resize_freeCoefficients(&columns);
+    resize_freeCoefficients(&lines);
+    return 1;
+}
@@ -0,0 +1,23 @@
+#ifndef RESIZE_H
+#define RESIZE_H
+
+#include <stdint.h>
+
+typedef enum {
+    RESIZE_BOX,        // Area average when shrinking, nearest when enlarging
+    RESIZE_BILINEAR,   // Triangle filter, widened when shrinking
+    RESIZE_LANCZOS3    // Windowed sinc over three lobes, sharpest
+} t_resize_filter;
+
+// Resamples src (srcWidth x srcHeight) into dst (dstWidth x dstHeight),
+// rows holding channels interleaved 8-bit samples. Filters are scaled to
+// the source pixel spacing when shrinking so that every source pixel
+// contributes. Weights are computed once per output column and row as
+// 14-bit fixed point; a horizontal pass over the needed source rows is
+// followed by a vertical pass, both parallel over rows. Box shrinking by
+// integer factors averages whole blocks in a single pass.
+// src and dst must not overlap. Returns 0 on allocation failure.
+int resize_image(uint8_t **src, int srcWidth, int srcHeight, uint8_t **dst, int dstWidth, int dstHeight,
+                 int channels, t_resize_filter filter);
+
+#endif // RESIZE_H
@@ -0,0 +1,255 @@
+#include "rotate.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Destination rows per task, and source rows per tile: a tile of 1-byte
+// pixels reads 64 cache lines and writes 64
+#define ROTATE_TILE 64
+
+typedef struct {
+    uint8_t **src;
+    uint8_t **dst;
+    int width;
+    int height;
+    int channels;
+    int horizontal;
+    int vertical;
+    int failed;
+} t_rotate_args;
+
+typedef uint8_t t_rotate_bytes __attribute__((vector_size(16)));
+
+// Shuffle masks that map to single SSE2 unpack or pack instructions
+static const t_rotate_bytes rotate_unpackLow = {0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23};
+static const t_rotate_bytes rotate_unpackHigh = {8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31};
+static const t_rotate_bytes rotate_highHalf = {8, 9, 10, 11, 12, 13, 14, 15, 8, 9, 10, 11, 12, 13, 14, 15};
+static const t_rotate_bytes rotate_lowHalves = {0, 1, 2, 3, 4, 5, 6, 7, 16, 17, 18, 19, 20, 21, 22, 23};
+static const t_rotate_bytes rotate_even = {0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30};
+static const t_rotate_bytes rotate_odd = {1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31};
+
+// Swaps the two halves of each pair of words, for element size bits
+static void rotate_swapBlocks(uint64_t *a, uint64_t *b, int bits, uint64_t mask) {
+    uint64_t t = ((*a >> bits) ^ *b) & mask;
+    *b ^= t;
+    *a ^= t << bits;
+}
+
+// 8x8 bytes from src (at column x of rows y to y + 7) to dst (at column y
+// of rows x to x + 7): 2x2 blocks of bytes, then of byte pairs, then of
+// 4-byte halves are swapped across the diagonal. Bytes are in memory
+// order, so this holds on little-endian machines only.
+static void rotate_block8(uint8_t **src, uint8_t **dst, int x, int y) {
+    uint64_t r[8];
+    for (int i = 0; i < 8; i++) memcpy(&r[i], src[y + i] + x, 8);
+
+    for (int i = 0; i < 8; i += 2) rotate_swapBlocks(&r[i], &r[i + 1], 8, 0x00FF00FF00FF00FFULL);
+    for (int i = 0; i < 8; i += 4) {
+        rotate_swapBlocks(&r[i], &r[i + 2], 16, 0x0000FFFF0000FFFFULL);
+        rotate_swapBlocks(&r[i + 1], &r[i + 3], 16, 0x0000FFFF0000FFFFULL);
+    }
+    for (int i = 0; i < 4; i++) rotate_swapBlocks(&r[i], &r[i + 4], 32, 0x00000000FFFFFFFFULL);
+
+    for (int i = 0; i < 8; i++) memcpy(dst[x + i] + y, &r[i], 8);
+}
+
+// Separates 16 pixels of 3 bytes into one vector per channel: each round
+// interleaves the low halves of pairs of vectors, and four rounds bring
+// every byte back to its channel
+static void rotate_split(const uint8_t *pixels, t_rotate_bytes v[3]) {
+    memcpy(v, pixels, 3 * sizeof(t_rotate_bytes));
+
+    for (int round = 0; round < 4; round++) {
+        t_rotate_bytes high0 = __builtin_shuffle(v[0], rotate_highHalf);
+        t_rotate_bytes high1 = __builtin_shuffle(v[1], rotate_highHalf);
+        t_rotate_bytes high2 = __builtin_shuffle(v[2], rotate_highHalf);
+        t_rotate_bytes next0 = __builtin_shuffle(v[0], high1, rotate_unpackLow);
+        t_rotate_bytes next1 = __builtin_shuffle(high0, v[2], rotate_unpackLow);
+        t_rotate_bytes next2 = __builtin_shuffle(v[1], high2, rotate_unpackLow);
+        v[0] = next0;
+        v[1] = next1;
+        v[2] = next2;
+    }
+}
+
+// Inverse of rotate_split, from even and odd bytes
+static void rotate_merge(t_rotate_bytes v[3], uint8_t *pixels) {
+    for (int round = 0; round < 4; round++) {
+        t_rotate_bytes even = __builtin_shuffle(v[2], v[0], rotate_even);
+        t_rotate_bytes odd = __builtin_shuffle(v[0], v[2], rotate_odd);
+        t_rotate_bytes next0 = __builtin_shuffle(v[0], v[1], rotate_even);
+        t_rotate_bytes next2 = __builtin_shuffle(v[1], v[2], rotate_odd);
+        v[1] = __builtin_shuffle(even, odd, rotate_lowHalves);
+        v[0] = next0;
+        v[2] = next2;
+    }
+    memcpy(pixels, v, 3 * sizeof(t_rotate_bytes));
+}
+
+// 16x16 bytes in place: interleaving row i with row i + 8 four times over
+// transposes the block
+static void rotate_transpose16(t_rotate_bytes r[16]) {
+    for (int round = 0; round < 4; round++) {
+        t_rotate_bytes next[16];
+        for (int i = 0; i < 8; i++) {
+            next[2 * i] = __builtin_shuffle(r[i], r[i + 8], rotate_unpackLow);
+            next[2 * i + 1] = __builtin_shuffle(r[i], r[i + 8], rotate_unpackHigh);
+        }
+        memcpy(r, next, sizeof(next));
+    }
+}
+
+// 16x16 pixels of 3 bytes, split into channel planes that are transposed
+// on their own and merged back
+static void rotate_block16x3(uint8_t **src, uint8_t **dst, int x, int y) {
+    t_rotate_bytes planes[3][16];
+    t_rotate_bytes v[3];
+
+    for (int i = 0; i < 16; i++) {
+        rotate_split(src[y + i] + x * 3, v);
+        for (int c = 0; c < 3; c++) planes[c][i] = v[c];
+    }
+    for (int c = 0; c < 3; c++) rotate_transpose16(planes[c]);
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) v[c] = planes[c][i];
+        rotate_merge(v, dst[x + i] + y * 3);
+    }
+}
+
+static void rotate_copy3(const t_rotate_args *args, int x, int y) {
+    const uint8_t *src = args->src[y] + x * 3;
+    uint8_t *dst = args->dst[x] + y * 3;
+    dst[0] = src[0];
+    dst[1] = src[1];
+    dst[2] = src[2];
+}
+
+// One tile: source rows [y0, y1) and columns [x0, x1)
+static void rotate_tile(const t_rotate_args *args, int x0, int x1, int y0, int y1) {
+    int ch = args->channels;
+
+    if (ch == 1 && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) {
+        int blockX1 = x0 + (x1 - x0) / 8 * 8;
+        int blockY1 = y0 + (y1 - y0) / 8 * 8;
+        for (int y = y0; y < blockY1; y += 8) {
+            for (int x = x0; x < blockX1; x += 8) rotate_block8(args->src, args->dst, x, y);
+        }
+        // Leftover columns and rows
+        for (int x = blockX1; x < x1; x++) {
+            for (int y = y0; y < y1; y++) args->dst[x][y] = args->src[y][x];
+        }
+        for (int y = blockY1; y < y1; y++) {
+            for (int x = x0; x < blockX1; x++) args->dst[x][y] = args->src[y][x];
+        }
+    } else if (ch == 3) {
+        int blockX1 = x0 + (x1 - x0) / 16 * 16;
+        int blockY1 = y0 + (y1 - y0) / 16 * 16;
+        for (int y = y0; y < blockY1; y += 16) {
+            for (int x = x0; x < blockX1; x += 16) rotate_block16x3(args->src, args->dst, x, y);
+        }
+        for (int x = blockX1; x < x1; x++) {
+            for (int y = y0; y < y1; y++) rotate_copy3(args, x, y);
+        }
+        for (int y = blockY1; y < y1; y++) {
+            for (int x = x0; x < blockX1; x++) rotate_copy3(args, x, y);
+        }
+    } else {
+        for (int x = x0; x < x1; x++) {
+            for (int y = y0; y < y1; y++) memcpy(args->dst[x] + y * ch, args->src[y] + x * ch, ch);
+        }
+    }
+}
+
+// Tasks own bands of destination rows, that is of source columns
+static void rotate_transposeTiles(void *ctx, int begin, int end) {
+    t_rotate_args *args = (t_rotate_args *)ctx;
+
+    for (int tile = begin; tile < end; tile++) {
+        int x0 = tile * ROTATE_TILE;
+        int x1 = x0 + ROTATE_TILE < args->width ? x0 + ROTATE_TILE : args->width;
+        for (int y0 = 0; y0 < args->height; y0 += ROTATE_TILE) {
+            int y1 = y0 + ROTATE_TILE < args->height ? y0 + ROTATE_TILE : args->height;
+            rotate_tile(args, x0, x1, y0, y1);
+        }
+    }
+}
+
+void rotate_transpose(uint8_t **src, uint8_t **dst, int width, int height, int channels) {
+    if (!src || !dst || width <= 0 || height <= 0 || channels <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return;
+    }
+
+    t_rotate_args args = {src, dst, width, height, channels, 0, 0, 0};
+    int tiles = (width + ROTATE_TILE - 1) / ROTATE_TILE;
+    scheduler_parallelFor(0, tiles, 1, rotate_transposeTiles, &args);
+}
+
+static void rotate_reverseInto(uint8_t *dst, const uint8_t *src, int width, int ch) {
+    const uint8_t *last = src + (size_t)(width - 1) * ch;
+    for (int x = 0; x < width; x++) {
+        for (int c = 0; c < ch; c++) dst[x * ch + c] = last[c - x * ch];
+    }
+}
+
+static void rotate_reverse(uint8_t *row, int width, int ch) {
+    for (int x = 0; x < width / 2; x++) {
+        uint8_t *a = row + (size_t)x * ch;
+        uint8_t *b = row + (size_t)(width - 1 - x) * ch;
+        for (int c = 0; c < ch; c++) {
+            uint8_t t = a[c];
+            a[c] = b[c];
+            b[c] = t;
+        }
+    }
+}
+
+static void rotate_mirrorRows(void *ctx, int begin, int end) {
+    t_rotate_args *args = (t_rotate_args *)ctx;
+    int ch = args->channels;
+    size_t rowSize = (size_t)args->width * ch;
+    uint8_t *temp = NULL;
+    if (args->vertical) {
+        temp = (uint8_t *)malloc(rowSize);
+        if (!temp) {
+            __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+
+    for (int y = begin; y < end; y++) {
+        int partner = args->vertical ? args->height - 1 - y : y;
+        uint8_t *a = args->src[y];
+        uint8_t *b = args->src[partner];
+
+        if (partner == y) {
+            if (args->horizontal) rotate_reverse(a, args->width, ch);
+        } else {
+            memcpy(temp, a, rowSize);
+            if (args->horizontal) {
+                rotate_reverseInto(a, b, args->width, ch);
+                rotate_reverseInto(b, temp, args->width, ch);
+            } else {
+                memcpy(a, b, rowSize);
+                memcpy(b, temp, rowSize);
+            }
+        }
+    }
+
+    free(temp);
+}
+
+int rotate_mirror(uint8_t **rows, int width, int height, int channels, int horizontal, int vertical) {
+    if (!rows || width <= 0 || height <= 0 || channels <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    // A vertical flip visits each pair of rows once, from the top half
+    t_rotate_args args = {rows, NULL, width, height, channels, horizontal, vertical, 0};
+    int count = vertical ? (height + 1) / 2 : height;
+    scheduler_parallelFor(0, count, scheduler_rowGrain(width), rotate_mirrorRows, &args);
+    if (args.failed) fprintf(stderr, "Error: Memory allocation failed\n");
+    return !args.failed;
+}
@@ -0,0 +1,20 @@
+#ifndef ROTATE_H
+#define ROTATE_H
+
+#include <stdint.h>
+
+// dst[x][y] = src[y][x] for a width x height source; dst has height
+// pixels per row and width rows. Rotations are transposes of reversed
+// row pointer arrays: reversing src gives 90 degrees clockwise, reversing
+// dst 90 degrees counterclockwise. Tiles run in parallel; 8-bit planes
+// are transposed as 8x8 blocks held in eight 64-bit registers, 24-bit
+// pixels as 16x16 blocks split into one 16-byte vector per channel.
+// src and dst must not overlap.
+void rotate_transpose(uint8_t **src, uint8_t **dst, int width, int height, int channels);
+
+// Mirrors rows left to right and/or swaps them top to bottom, in place;
+// both together turn the image by 180 degrees.
+// Returns 0 on allocation failure.
+int rotate_mirror(uint8_t **rows, int width, int height, int channels, int horizontal, int vertical);
+
+#endif // ROTATE_H
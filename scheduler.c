@@ -0,0 +1,345 @@
+#include "scheduler.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+// Pixels handled by one task before it is worth splitting a range further
+#define SCHEDULER_TASK_PIXELS 32768
+
+typedef struct {
+    t_range_fn fn;
+    void *ctx;
+    int grain;
+} t_range_job;
+
+// A task is either a plain call (fn set) or a sub-range of a parallelFor
+// job (fn NULL, arg pointing to the t_range_job)
+typedef struct {
+    t_task_fn fn;
+    void *arg;
+    t_task_group *group;
+    int begin;
+    int end;
+} t_task;
+
+typedef struct {
+    t_task *tasks;
+    int capacity;
+    int head;
+    int count;
+    pthread_mutex_t lock;
+} t_deque;
+
+typedef struct {
+    int workers;
+    t_deque *deques;       // one per worker, plus the injection deque last
+    pthread_t *threads;
+    int queued;
+    int sleepers;
+    int stopping;
+    pthread_mutex_t sleepLock;
+    pthread_cond_t wake;
+} t_scheduler;
+
+static t_scheduler scheduler;
+static int scheduler_started = 0;
+static pthread_mutex_t scheduler_initLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t scheduler_workerKey;
+
+// Deque operations
+static int deque_init(t_deque *deque) {
+    deque->capacity = 64;
+    deque->head = 0;
+    deque->count = 0;
+    deque->tasks = (t_task *)malloc(deque->capacity * sizeof(t_task));
+    if (!deque->tasks) return 0;
+    pthread_mutex_init(&deque->lock, NULL);
+    return 1;
+}
+
+static void deque_destroy(t_deque *deque) {
+    pthread_mutex_destroy(&deque->lock);
+    free(deque->tasks);
+}
+
+static int deque_pushBottom(t_deque *deque, t_task task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count == deque->capacity) {
+        t_task *grown = (t_task *)malloc(2 * deque->capacity * sizeof(t_task));
+        if (!grown) {
+            pthread_mutex_unlock(&deque->lock);
+            return 0;
+        }
+        for (int i = 0; i < deque->count; i++) {
+            grown[i] = deque->tasks[(deque->head + i) % deque->capacity];
+        }
+        free(deque->tasks);
+        deque->tasks = grown;
+        deque->head = 0;
+        deque->capacity *= 2;
+    }
+    deque->tasks[(deque->head + deque->count) % deque->capacity] = task;
+    __atomic_store_n(&deque->count, deque->count + 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&deque->lock);
+    return 1;
+}
+
+// The owner takes its newest task, which is the most likely to be in cache
+static int deque_popBottom(t_deque *deque, t_task *task) {
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        __atomic_store_n(&deque->count, deque->count - 1, __ATOMIC_RELAXED);
+        *task = deque->tasks[(deque->head + deque->count) % deque->capacity];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// Thieves take the oldest task, which is usually the largest range. The
+// count is peeked without the lock so that empty deques are skipped cheaply.
+static int deque_stealTop(t_deque *deque, t_task *task) {
+    int found = 0;
+    if (__atomic_load_n(&deque->count, __ATOMIC_RELAXED) == 0) return 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        *task = deque->tasks[deque->head];
+        deque->head = (deque->head + 1) % deque->capacity;
+        __atomic_store_n(&deque->count, deque->count - 1, __ATOMIC_RELAXED);
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// Index of the calling worker, or -1 for threads outside the pool
+static int scheduler_self(void) {
+    void *value = pthread_getspecific(scheduler_workerKey);
+    return value ? (int)(intptr_t)value - 1 : -1;
+}
+
+static int scheduler_findTask(int self, t_task *task) {
+    int total = scheduler.workers + 1;
+    int own = self >= 0 ? self : scheduler.workers;
+    int found = deque_popBottom(&scheduler.deques[own], task);
+
+    for (int i = 1; !found && i < total; i++) {
+        found = deque_stealTop(&scheduler.deques[(own + i) % total], task);
+    }
+    if (found) {
+        __atomic_sub_fetch(&scheduler.queued, 1, __ATOMIC_SEQ_CST);
+    }
+    return found;
+}
+
+static void scheduler_push(t_task task) {
+    int self = scheduler_self();
+    t_deque *deque = &scheduler.deques[self >= 0 ? self : scheduler.workers];
+
+    if (!deque_pushBottom(deque, task)) {
+        // Out of memory: run the task in place rather than losing it
+        if (task.fn) {
+            task.fn(task.arg);
+        } else {
+            t_range_job *job = (t_range_job *)task.arg;
+            job->fn(job->ctx, task.begin, task.end);
+        }
+        __atomic_sub_fetch(&task.group->pending, 1, __ATOMIC_ACQ_REL);
+        return;
+    }
+
+    __atomic_add_fetch(&scheduler.queued, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&scheduler.sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&scheduler.sleepLock);
+        pthread_cond_signal(&scheduler.wake);
+        pthread_mutex_unlock(&scheduler.sleepLock);
+    }
+}
+
+static void scheduler_run(t_task task) {
+    if (task.fn) {
+        task.fn(task.arg);
+    } else {
+        // Keep splitting the range, leaving the upper halves for thieves
+        t_range_job *job = (t_range_job *)task.arg;
+        while (task.end - task.begin > job->grain) {
+            t_task half = task;
+            half.begin = task.begin + (task.end - task.begin) / 2;
+            task.end = half.begin;
+            __atomic_add_fetch(&task.group->pending, 1, __ATOMIC_ACQ_REL);
+            scheduler_push(half);
+        }
+        job->fn(job->ctx, task.begin, task.end);
+    }
+    __atomic_sub_fetch(&task.group->pending, 1, __ATOMIC_ACQ_REL);
+}
+
+static void *scheduler_worker(void *arg) {
+    int self = (int)(intptr_t)arg;
+    t_task task;
+
+    pthread_setspecific(scheduler_workerKey, (void *)(intptr_t)(self + 1));
+
+    while (!__atomic_load_n(&scheduler.stopping, __ATOMIC_ACQUIRE)) {
+        if (scheduler_findTask(self, &task)) {
+            scheduler_run(task);
+            continue;
+        }
+
+        pthread_mutex_lock(&scheduler.sleepLock);
+        __atomic_add_fetch(&scheduler.sleepers, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&scheduler.queued, __ATOMIC_SEQ_CST) == 0 &&
+               !__atomic_load_n(&scheduler.stopping, __ATOMIC_ACQUIRE)) {
+            pthread_cond_wait(&scheduler.wake, &scheduler.sleepLock);
+        }
+        __atomic_sub_fetch(&scheduler.sleepers, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&scheduler.sleepLock);
+    }
+    return NULL;
+}
+
+void scheduler_init(int threads) {
+    pthread_mutex_lock(&scheduler_initLock);
+    if (scheduler_started) {
+        pthread_mutex_unlock(&scheduler_initLock);
+        return;
+    }
+
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    // The thread waiting on a group helps, so the pool needs one less thread
+    scheduler.workers = threads > 1 ? threads - 1 : 0;
+    scheduler.queued = 0;
+    scheduler.sleepers = 0;
+    scheduler.stopping = 0;
+    pthread_mutex_init(&scheduler.sleepLock, NULL);
+    pthread_cond_init(&scheduler.wake, NULL);
+    pthread_key_create(&scheduler_workerKey, NULL);
+
+    scheduler.deques = (t_deque *)malloc((scheduler.workers + 1) * sizeof(t_deque));
+    scheduler.threads = (pthread_t *)malloc((scheduler.workers + 1) * sizeof(pthread_t));
+    if (!scheduler.deques || !scheduler.threads) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i <= scheduler.workers; i++) {
+        if (!deque_init(&scheduler.deques[i])) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (int i = 0; i < scheduler.workers; i++) {
+        if (pthread_create(&scheduler.threads[i], NULL, scheduler_worker, (void *)(intptr_t)i) != 0) {
+            // Tasks still complete: waiting threads run whatever is queued
+            fprintf(stderr, "Warning: Could only start %d scheduler threads\n", i);
+            scheduler.workers = i;
+            break;
+        }
+    }
+
+    scheduler_started = 1;
+    pthread_mutex_unlock(&scheduler_initLock);
+}
+
+void scheduler_shutdown(void) {
+    pthread_mutex_lock(&scheduler_initLock);
+    if (!scheduler_started) {
+        pthread_mutex_unlock(&scheduler_initLock);
+        return;
+    }
+
+    pthread_mutex_lock(&scheduler.sleepLock);
+    __atomic_store_n(&scheduler.stopping, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&scheduler.wake);
+    pthread_mutex_unlock(&scheduler.sleepLock);
+
+    for (int i = 0; i < scheduler.workers; i++) {
+        pthread_join(scheduler.threads[i], NULL);
+    }
+    for (int i = 0; i <= scheduler.workers; i++) {
+        deque_destroy(&scheduler.deques[i]);
+    }
+    free(scheduler.deques);
+    free(scheduler.threads);
+    pthread_mutex_destroy(&scheduler.sleepLock);
+    pthread_cond_destroy(&scheduler.wake);
+    pthread_key_delete(scheduler_workerKey);
+
+    scheduler_started = 0;
+    pthread_mutex_unlock(&scheduler_initLock);
+}
+
+static void scheduler_ensureStarted(void) {
+    if (!__atomic_load_n(&scheduler_started, __ATOMIC_ACQUIRE)) {
+        scheduler_init(0);
+    }
+}
+
+int scheduler_threadCount(void) {
+    scheduler_ensureStarted();
+    return scheduler.workers + 1;
+}
+
+void scheduler_spawn(t_task_group *group, t_task_fn fn, void *arg) {
+    if (!group || !fn) return;
+    scheduler_ensureStarted();
+
+    t_task task = {fn, arg, group, 0, 0};
+    __atomic_add_fetch(&group->pending, 1, __ATOMIC_ACQ_REL);
+    scheduler_push(task);
+}
+
+void scheduler_waitUntil(t_task_group *group, int maxPending) {
+    if (!group) return;
+    scheduler_ensureStarted();
+
+    int self = scheduler_self();
+    t_task task;
+    while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > maxPending) {
+        if (scheduler_findTask(self, &task)) {
+            scheduler_run(task);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+void scheduler_wait(t_task_group *group) {
+    scheduler_waitUntil(group, 0);
+}
+
+void scheduler_parallelFor(int begin, int end, int grain, t_range_fn fn, void *ctx) {
+    if (!fn || end <= begin) return;
+
+    int threads = scheduler_threadCount();
+    if (grain <= 0) {
+        grain = (end - begin + threads * 4 - 1) / (threads * 4);
+        if (grain < 1) grain = 1;
+    }
+
+    // Not worth any task overhead
+    if (threads == 1 || end - begin <= grain) {
+        fn(ctx, begin, end);
+        return;
+    }
+
+    t_range_job job = {fn, ctx, grain};
+    t_task_group group = {1};
+    t_task task = {NULL, &job, &group, begin, end};
+    scheduler_run(task);
+    scheduler_wait(&group);
+}
+
+int scheduler_rowGrain(int width) {
+    if (width <= 0) return 1;
+    int rows = SCHEDULER_TASK_PIXELS / width;
+    return rows > 0 ? rows : 1;
+}
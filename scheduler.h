@@ -0,0 +1,40 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// Work-stealing task scheduler shared by the batch pipeline and the filters.
+// Every worker owns a deque: it pushes and pops its own tasks at the bottom
+// while idle workers steal the oldest tasks from the top of other deques.
+// Threads outside the pool submit into a shared injection deque and help
+// running tasks while they wait.
+
+typedef void (*t_task_fn)(void *arg);
+typedef void (*t_range_fn)(void *ctx, int begin, int end);
+
+// Counts the unfinished tasks spawned into it
+typedef struct {
+    int pending;
+} t_task_group;
+
+// Starts the pool with the given number of threads (0 = one per CPU).
+// Calling it is optional: the first use starts a pool with the default size.
+void scheduler_init(int threads);
+void scheduler_shutdown(void);
+
+// Number of threads that can run tasks, including the caller
+int scheduler_threadCount(void);
+
+void scheduler_spawn(t_task_group *group, t_task_fn fn, void *arg);
+
+// Runs queued tasks until at most maxPending tasks of the group remain
+void scheduler_waitUntil(t_task_group *group, int maxPending);
+void scheduler_wait(t_task_group *group);
+
+// Calls fn on sub-ranges of [begin, end) in parallel. Ranges larger than
+// grain split themselves in half so that idle threads can steal the other
+// half; grain <= 0 picks one from the thread count.
+void scheduler_parallelFor(int begin, int end, int grain, t_range_fn fn, void *ctx);
+
+// Row grain that gives each task roughly the same number of pixels
+int scheduler_rowGrain(int width);
+
+#endif // SCHEDULER_H
@@ -0,0 +1,216 @@
+#include "unsharp.h"
+#include "pool.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Rows are written back as soon as they are blended, so a band cannot
+// read the rows of its neighbours once they start. Each band first blurs
+// the radius rows above it (they go into its ring) and the radius rows
+// below it (kept aside); only then do the bands stream.
+
+typedef struct {
+    uint8_t **rows;
+    int width;
+    int height;
+    int channels;
+    int radius;
+    const float *kernel;   // 2 * radius + 1 weights
+    float amount;
+    int threshold;
+    int bandHeight;
+    size_t lineStride;     // Floats per scratch row
+    float **scratch;       // Per band: ring rows, then radius rows below
+    int failed;
+} t_unsharp_args;
+
+static int unsharp_clamp(int v, int low, int high) {
+    return v < low ? low : (v > high ? high : v);
+}
+
+// Horizontal blur of one image row. line holds the row as floats with
+// radius pixels of edge extension on both sides.
+static void unsharp_blurRow(const t_unsharp_args *args, int y, float *line, float *dst) {
+    int ch = args->channels;
+    int r = args->radius;
+    int samples = args->width * ch;
+    const uint8_t *src = args->rows[unsharp_clamp(y, 0, args->height - 1)];
+
+    for (int x = -r; x < args->width + r; x++) {
+        const uint8_t *pixel = src + unsharp_clamp(x, 0, args->width - 1) * ch;
+        for (int c = 0; c < ch; c++) line[(x + r) * ch + c] = pixel[c];
+    }
+
+    memset(dst, 0, samples * sizeof(float));
+    for (int j = 0; j <= 2 * r; j++) {
+        float weight = args->kernel[j];
+        const float *shifted = line + j * ch;
+        for (int i = 0; i < samples; i++) dst[i] += weight * shifted[i];
+    }
+}
+
+static float *unsharp_ringRow(const t_unsharp_args *args, float *scratch, int band, int y) {
+    int first = band * args->bandHeight - args->radius;
+    return scratch + (size_t)((y - first) % (2 * args->radius + 1)) * args->lineStride;
+}
+
+static float *unsharp_belowRow(const t_unsharp_args *args, float *scratch, int band, int y) {
+    int bandEnd = (band + 1) * args->bandHeight;
+    return scratch + (size_t)(2 * args->radius + 1 + y - bandEnd) * args->lineStride;
+}
+
+static int unsharp_bandEnd(const t_unsharp_args *args, int band) {
+    int end = (band + 1) * args->bandHeight;
+    return end < args->height ? end : args->height;
+}
+
+// First phase: the halo rows that neighbouring bands will overwrite
+static void unsharp_halos(void *ctx, int begin, int end) {
+    t_unsharp_args *args = (t_unsharp_args *)ctx;
+    int r = args->radius;
+    float *line = (float *)malloc((size_t)(args->width + 2 * r) * args->channels * sizeof(float));
+    if (!line) {
+        __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    for (int band = begin; band < end; band++) {
+        float *scratch = args->scratch[band];
+        int y0 = band * args->bandHeight;
+        int y1 = unsharp_bandEnd(args, band);
+        if (!scratch) continue;
+
+        for (int y = y0 - r; y < y0; y++) {
+            unsharp_blurRow(args, y, line, unsharp_ringRow(args, scratch, band, y));
+        }
+        // Past the last band the rows belong to no one and are read later
+        if (y1 < args->height) {
+            for (int y = y1; y < y1 + r; y++) {
+                unsharp_blurRow(args, y, line, unsharp_belowRow(args, scratch, band, y));
+            }
+        }
+    }
+
+    free(line);
+}
+
+// Second phase: blur the band's own rows into the ring as they are needed,
+// blur vertically and blend each output row in place
+static void unsharp_bands(void *ctx, int begin, int end) {
+    t_unsharp_args *args = (t_unsharp_args *)ctx;
+    int r = args->radius;
+    int samples = args->width * args->channels;
+    float *line = (float *)malloc((size_t)(args->width + 2 * r) * args->channels * sizeof(float));
+    float *blur = (float *)malloc(samples * sizeof(float));
+    if (!line || !blur) {
+        __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+        free(line);
+        free(blur);
+        return;
+    }
+
+    for (int band = begin; band < end; band++) {
+        float *scratch = args->scratch[band];
+        int y0 = band * args->bandHeight;
+        int y1 = unsharp_bandEnd(args, band);
+        if (!scratch) continue;
+
+        for (int y = y0; y < y0 + r; y++) {
+            if (y < y1 || y1 == args->height) {
+                unsharp_blurRow(args, y, line, unsharp_ringRow(args, scratch, band, y));
+            } else {
+                memcpy(unsharp_ringRow(args, scratch, band, y), unsharp_belowRow(args, scratch, band, y),
+                       samples * sizeof(float));
+            }
+        }
+
+        for (int y = y0; y < y1; y++) {
+            // Bring in the row entering the window at the bottom
+            int next = y + r;
+            float *slot = unsharp_ringRow(args, scratch, band, next);
+            if (next < y1 || y1 == args->height) {
+                unsharp_blurRow(args, next, line, slot);
+            } else {
+                memcpy(slot, unsharp_belowRow(args, scratch, band, next), samples * sizeof(float));
+            }
+
+            memset(blur, 0, samples * sizeof(float));
+            for (int j = -r; j <= r; j++) {
+                float weight = args->kernel[j + r];
+                const float *src = unsharp_ringRow(args, scratch, band, y + j);
+                for (int i = 0; i < samples; i++) blur[i] += weight * src[i];
+            }
+
+            uint8_t *row = args->rows[y];
+            for (int i = 0; i < samples; i++) {
+                float difference = row[i] - blur[i];
+                if (fabsf(difference) < args->threshold) continue;
+                float value = row[i] + args->amount * difference + 0.5f;
+                row[i] = (uint8_t)(value > 255 ? 255 : (value < 0 ? 0 : value));
+            }
+        }
+    }
+
+    free(line);
+    free(blur);
+}
+
+int unsharp_apply(uint8_t **rows, int width, int height, int channels, float sigma, float amount, int threshold) {
+    if (!rows || width <= 0 || height <= 0 || channels <= 0 || sigma <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    t_unsharp_args args;
+    args.rows = rows;
+    args.width = width;
+    args.height = height;
+    args.channels = channels;
+    args.radius = (int)ceilf(3.0f * sigma);
+    args.amount = amount;
+    args.threshold = threshold;
+    args.lineStride = POOL_ROW_STRIDE((size_t)width * channels);
+    args.failed = 0;
+
+    int r = args.radius;
+    float *kernel = (float *)malloc((2 * r + 1) * sizeof(float));
+    if (!kernel) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return 0;
+    }
+    float total = 0;
+    for (int j = -r; j <= r; j++) {
+        kernel[j + r] = expf(-(float)(j * j) / (2.0f * sigma * sigma));
+        total += kernel[j + r];
+    }
+    for (int j = 0; j <= 2 * r; j++) kernel[j] /= total;
+    args.kernel = kernel;
+
+    // A few bands per thread, tall enough that halos stay a small overhead
+    int bandHeight = (height + scheduler_threadCount() * 4 - 1) / (scheduler_threadCount() * 4);
+    if (bandHeight < 4 * r) bandHeight = 4 * r;
+    args.bandHeight = bandHeight;
+    int bands = (height + bandHeight - 1) / bandHeight;
+
+    args.scratch = (float **)calloc(bands, sizeof(float *));
+    if (!args.scratch) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(kernel);
+        return 0;
+    }
+    for (int b = 0; b < bands && !args.failed; b++) {
+        args.scratch[b] = (float *)pool_acquire(args.lineStride * (3 * r + 1) * sizeof(float));
+        if (!args.scratch[b]) args.failed = 1;
+    }
+
+    if (!args.failed) scheduler_parallelFor(0, bands, 1, unsharp_halos, &args);
+    if (!args.failed) scheduler_parallelFor(0, bands, 1, unsharp_bands, &args);
+    if (args.failed) fprintf(stderr, "Error: Memory allocation failed\n");
+
+    for (int b = 0; b < bands; b++) pool_release(args.scratch[b]);
+    free(args.scratch);
+    free(kernel);
+    return !args.failed;
+}
@@ -0,0 +1,16 @@
+#ifndef UNSHARP_H
+#define UNSHARP_H
+
+#include <stdint.h>
+
+// Unsharp mask: out = in + amount * (in - blur(in)) wherever the difference
+// is at least threshold, blur being a Gaussian of the given sigma. Rows are
+// blurred horizontally into a ring of 2 * radius + 1 float rows, blurred
+// vertically from the ring and blended straight back into the image, so no
+// full-size blurred copy is made. Bands of rows run in parallel.
+// rows[y] points to width pixels of channels interleaved 8-bit samples;
+// edges are extended with the border pixels.
+// Returns 0 on allocation failure.
+int unsharp_apply(uint8_t **rows, int width, int height, int channels, float sigma, float amount, int threshold);
+
+#endif // UNSHARP_H
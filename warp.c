@@ -0,0 +1,273 @@
+#include "warp.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Output tile side: the source footprint of a tile stays within a few
+// dozen rows, which stay in cache while the tile's rows are sampled
+#define WARP_TILE 64
+#define WARP_FRACTION_BITS 16
+#define WARP_ONE (1 << WARP_FRACTION_BITS)
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct {
+    uint8_t **src;
+    int srcWidth;
+    int srcHeight;
+    uint8_t **dst;
+    int dstWidth;
+    int dstHeight;
+    int channels;
+    double m[3][3];
+    int affine;
+    const uint8_t *background;
+    int tilesX;
+} t_warp_args;
+
+static void warp_fill(const t_warp_args *args, uint8_t *out, int count) {
+    int ch = args->channels;
+    if (ch == 1) {
+        memset(out, args->background[0], count);
+        return;
+    }
+    for (int i = 0; i < count; i++) memcpy(out + i * ch, args->background, ch);
+}
+
+// Bilinear sample at the 16.16 fixed-point position (sx, sy), in pixel
+// center coordinates; neighbours past the border repeat the edge
+static void warp_sample(const t_warp_args *args, int64_t sx, int64_t sy, uint8_t *out) {
+    int ch = args->channels;
+    int ix = (int)(sx >> WARP_FRACTION_BITS);
+    int iy = (int)(sy >> WARP_FRACTION_BITS);
+    uint32_t fx = (uint32_t)(sx >> (WARP_FRACTION_BITS - 8)) & 0xFF;
+    uint32_t fy = (uint32_t)(sy >> (WARP_FRACTION_BITS - 8)) & 0xFF;
+    int x0 = ix < 0 ? 0 : ix;
+    int x1 = ix + 1 < args->srcWidth ? ix + 1 : args->srcWidth - 1;
+    int y0 = iy < 0 ? 0 : iy;
+    int y1 = iy + 1 < args->srcHeight ? iy + 1 : args->srcHeight - 1;
+    const uint8_t *top = args->src[y0];
+    const uint8_t *bottom = args->src[y1];
+
+    for (int c = 0; c < ch; c++) {
+        uint32_t upper = top[x0 * ch + c] * (256 - fx) + top[x1 * ch + c] * fx;
+        uint32_t lower = bottom[x0 * ch + c] * (256 - fx) + bottom[x1 * ch + c] * fx;
+        out[c] = (uint8_t)((upper * (256 - fy) + lower * fy + 32768) >> 16);
+    }
+}
+
+// Steps t in [0, count) for which 0 <= start + t * step < limit
+static void warp_span(double start, double step, double limit, int count, int *low, int *high) {
+    double lo, hi;
+    if (step > 0) {
+        lo = ceil(-start / step);
+        hi = ceil((limit - start) / step);
+    } else if (step < 0) {
+        lo = floor((start - limit) / -step) + 1;
+        hi = floor(start / -step) + 1;
+    } else {
+        lo = start >= 0 && start < limit ? 0 : count;
+        hi = count;
+    }
+    if (lo > *low) *low = lo > count ? count : (int)lo;
+    if (hi < *high) *high = hi < 0 ? 0 : (int)hi;
+}
+
+static void warp_affineRow(const t_warp_args *args, int y, int x0, int x1) {
+    int ch = args->channels;
+    const double (*m)[3] = args->m;
+    double sx = m[0][0] * (x0 + 0.5) + m[0][1] * (y + 0.5) + m[0][2];
+    double sy = m[1][0] * (x0 + 0.5) + m[1][1] * (y + 0.5) + m[1][2];
+    uint8_t *out = args->dst[y] + (size_t)x0 * ch;
+    int count = x1 - x0;
+
+    int low = 0, high = count;
+    warp_span(sx, m[0][0], args->srcWidth, count, &low, &high);
+    warp_span(sy, m[1][0], args->srcHeight, count, &low, &high);
+    if (low >= high) {
+        warp_fill(args, out, count);
+        return;
+    }
+
+    warp_fill(args, out, low);
+    int64_t fx = llround((sx + low * m[0][0] - 0.5) * WARP_ONE);
+    int64_t fy = llround((sy + low * m[1][0] - 0.5) * WARP_ONE);
+    int64_t stepX = llround(m[0][0] * WARP_ONE);
+    int64_t stepY = llround(m[1][0] * WARP_ONE);
+    for (int i = low; i < high; i++) {
+        warp_sample(args, fx, fy, out + i * ch);
+        fx += stepX;
+        fy += stepY;
+    }
+    warp_fill(args, out + high * ch, count - high);
+}
+
+static void warp_perspectiveRow(const t_warp_args *args, int y, int x0, int x1) {
+    int ch = args->channels;
+    const double (*m)[3] = args->m;
+    double sx = m[0][0] * (x0 + 0.5) + m[0][1] * (y + 0.5) + m[0][2];
+    double sy = m[1][0] * (x0 + 0.5) + m[1][1] * (y + 0.5) + m[1][2];
+    double sw = m[2][0] * (x0 + 0.5) + m[2][1] * (y + 0.5) + m[2][2];
+    uint8_t *out = args->dst[y] + (size_t)x0 * ch;
+
+    for (int x = x0; x < x1; x++, out += ch) {
+        double px = sw != 0 ? sx / sw : -1;
+        double py = sw != 0 ? sy / sw : -1;
+        if (px >= 0 && px < args->srcWidth && py >= 0 && py < args->srcHeight) {
+            warp_sample(args, llround((px - 0.5) * WARP_ONE), llround((py - 0.5) * WARP_ONE), out);
+        } else {
+            warp_fill(args, out, 1);
+        }
+        sx += m[0][0];
+        sy += m[1][0];
+        sw += m[2][0];
+    }
+}
+
+// Whether the tile's source footprint, the quadrilateral spanned by its
+// mapped corners, misses the source. Not decided when the tile straddles
+// the line sent to infinity, whose footprint is not that quadrilateral.
+static int warp_tileOutside(const t_warp_args *args, int x0, int x1, int y0, int y1) {
+    const double (*m)[3] = args->m;
+    double minX = INFINITY, maxX = -INFINITY, minY = INFINITY, maxY = -INFINITY;
+    int positive = 0;
+
+    for (int corner = 0; corner < 4; corner++) {
+        double x = corner & 1 ? x1 : x0;
+        double y = corner & 2 ? y1 : y0;
+        double w = m[2][0] * x + m[2][1] * y + m[2][2];
+        if (w == 0) return 0;
+        positive += w > 0;
+        double sx = (m[0][0] * x + m[0][1] * y + m[0][2]) / w;
+        double sy = (m[1][0] * x + m[1][1] * y + m[1][2]) / w;
+        minX = fmin(minX, sx);
+        maxX = fmax(maxX, sx);
+        minY = fmin(minY, sy);
+        maxY = fmax(maxY, sy);
+    }
+    if (positive % 4) return 0;
+    return maxX < 0 || minX >= args->srcWidth || maxY < 0 || minY >= args->srcHeight;
+}
+
+static void warp_tiles(void *ctx, int begin, int end) {
+    t_warp_args *args = (t_warp_args *)ctx;
+
+    for (int tile = begin; tile < end; tile++) {
+        int x0 = tile % args->tilesX * WARP_TILE;
+        int y0 = tile / args->tilesX * WARP_TILE;
+        int x1 = x0 + WARP_TILE < args->dstWidth ? x0 + WARP_TILE : args->dstWidth;
+        int y1 = y0 + WARP_TILE < args->dstHeight ? y0 + WARP_TILE : args->dstHeight;
+
+        if (warp_tileOutside(args, x0, x1, y0, y1)) {
+            for (int y = y0; y < y1; y++) warp_fill(args, args->dst[y] + (size_t)x0 * args->channels, x1 - x0);
+            continue;
+        }
+
+        for (int y = y0; y < y1; y++) {
+            if (args->affine) {
+                warp_affineRow(args, y, x0, x1);
+            } else {
+                warp_perspectiveRow(args, y, x0, x1);
+            }
+        }
+    }
+}
+
+int warp_apply(uint8_t **src, int srcWidth, int srcHeight, uint8_t **dst, int dstWidth, int dstHeight,
+               int channels, const double matrix[3][3], const uint8_t *background) {
+    if (!src || !dst || !matrix || !background || srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 ||
+        dstHeight <= 0 || channels <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    t_warp_args args;
+    args.src = src;
+    args.srcWidth = srcWidth;
+    args.srcHeight = srcHeight;
+    args.dst = dst;
+    args.dstWidth = dstWidth;
+    args.dstHeight = dstHeight;
+    args.channels = channels;
+    args.background = background;
+    // Normalized so that affine matrices have a last row of 0 0 1
+    double scale = matrix[2][2] != 0 ? matrix[2][2] : 1;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) args.m[i][j] = matrix[i][j] / scale;
+    }
+    args.affine = args.m[2][0] == 0 && args.m[2][1] == 0;
+    args.tilesX = (dstWidth + WARP_TILE - 1) / WARP_TILE;
+    int tiles = args.tilesX * ((dstHeight + WARP_TILE - 1) / WARP_TILE);
+
+    scheduler_parallelFor(0, tiles, 1, warp_tiles, &args);
+    return 1;
+}
+
+int warp_quadToRect(const double quad[4][2], int width, int height, double matrix[3][3]) {
+    if (!quad || !matrix || width <= 0 || height <= 0) {
+        fprintf(stderr, "Error: Invalid parameters\n");
+        return 0;
+    }
+
+    // Unit square to quadrilateral first
+    double x0 = quad[0][0], y0 = quad[0][1];
+    double x1 = quad[1][0], y1 = quad[1][1];
+    double x2 = quad[2][0], y2 = quad[2][1];
+    double x3 = quad[3][0], y3 = quad[3][1];
+    double sx = x0 - x1 + x2 - x3;
+    double sy = y0 - y1 + y2 - y3;
+    double g = 0, h = 0;
+
+    if (sx != 0 || sy != 0) {
+        double dx1 = x1 - x2, dx2 = x3 - x2;
+        double dy1 = y1 - y2, dy2 = y3 - y2;
+        double denominator = dx1 * dy2 - dx2 * dy1;
+        if (denominator == 0) {
+            fprintf(stderr, "Error: Degenerate quadrilateral\n");
+            return 0;
+        }
+        g = (sx * dy2 - dx2 * sy) / denominator;
+        h = (dx1 * sy - sx * dy1) / denominator;
+    }
+
+    // Then scaled from the output rectangle
+    matrix[0][0] = (x1 - x0 + g * x1) / width;
+    matrix[0][1] = (x3 - x0 + h * x3) / height;
+    matrix[0][2] = x0;
+    matrix[1][0] = (y1 - y0 + g * y1) / width;
+    matrix[1][1] = (y3 - y0 + h * y3) / height;
+    matrix[1][2] = y0;
+    matrix[2][0] = g / width;
+    matrix[2][1] = h / height;
+    matrix[2][2] = 1;
+
+    double determinant = matrix[0][0] * (matrix[1][1] * matrix[2][2] - matrix[1][2] * matrix[2][1]) -
+                         matrix[0][1] * (matrix[1][0] * matrix[2][2] - matrix[1][2] * matrix[2][0]) +
+                         matrix[0][2] * (matrix[1][0] * matrix[2][1] - matrix[1][1] * matrix[2][0]);
+    if (determinant == 0) {
+        fprintf(stderr, "Error: Degenerate quadrilateral\n");
+        return 0;
+    }
+    return 1;
+}
+
+void warp_rotation(double degrees, int width, int height, double matrix[3][3]) {
+    // Output points are turned back counterclockwise onto the source
+    double angle = degrees * M_PI / 180;
+    double c = cos(angle), s = sin(angle);
+    double cx = width / 2.0, cy = height / 2.0;
+
+    matrix[0][0] = c;
+    matrix[0][1] = s;
+    matrix[0][2] = cx - c * cx - s * cy;
+    matrix[1][0] = -s;
+    matrix[1][1] = c;
+    matrix[1][2] = cy + s * cx - c * cy;
+    matrix[2][0] = 0;
+    matrix[2][1] = 0;
+    matrix[2][2] = 1;
+}
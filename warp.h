@@ -0,0 +1,30 @@
+#ifndef WARP_H
+#define WARP_H
+
+#include <stdint.h>
+
+// Resamples src into dst through a projective transform. matrix maps
+// output coordinates (x, y, 1) to homogeneous source coordinates, pixel
+// (i, j) covering [i, i + 1) x [j, j + 1). Source coordinates advance by a
+// constant step along each output row, so the matrix is only evaluated
+// once per row; affine matrices then step in 16.16 fixed point and get
+// the in-bounds span of each row solved up front, while perspective ones
+// divide once per pixel. Samples are bilinear with 8-bit weights; output
+// pixels falling outside the source get background (channels bytes).
+// The output is processed in tiles in parallel, and tiles whose source
+// footprint misses the image are filled without sampling.
+// src and dst must not overlap. Returns 0 on invalid parameters.
+int warp_apply(uint8_t **src, int srcWidth, int srcHeight, uint8_t **dst, int dstWidth, int dstHeight,
+               int channels, const double matrix[3][3], const uint8_t *background);
+
+// Matrix that maps the width x height output rectangle onto the source
+// quadrilateral quad, corners given clockwise from the top left; used
+// with warp_apply, it straightens the quadrilateral (Heckbert, 1989).
+// Returns 0 if the quadrilateral is degenerate.
+int warp_quadToRect(const double quad[4][2], int width, int height, double matrix[3][3]);
+
+// Matrix that turns a width x height image clockwise by degrees around its
+// center, keeping its size
+void warp_rotation(double degrees, int width, int height, double matrix[3][3]);
+
+#endif // WARP_H